@@ -0,0 +1,303 @@
+// Rendering benchmark on the GPU, headless, so it also runs on hosts without
+// a display, e.g. on lavapipe with `VK_ICD_FILENAMES` pointing at its ICD.
+//
+// Every scene renders into a 640x360 render target standing in for the
+// screen, for a fixed number of frames after a warm-up. Each frame is timed
+// from `TinyDraw_BeginFrame` until the GPU is idle again, & the scene reports
+// frame time percentiles, sprites per second & the counters of its last
+// frame. Sprite positions come from a fixed seed, so runs are comparable.
+// Run with `make bench`.
+
+#define TINYDRAW_IMPLEMENTATION
+#include "tinydraw.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC SDL_malloc
+#define STBI_REALLOC SDL_realloc
+#define STBI_FREE SDL_free
+#include "vendor/stb_image.h"
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 360
+#define BENCH_WARMUP 30
+#define BENCH_FRAMES 300
+#define BENCH_SPRITES 100000
+#define BENCH_TEXTURES 64
+#define BENCH_TEXTURE_SIZE 64
+#define BENCH_TILE_SIZE 16
+#define BENCH_MAP_SIZE 256
+#define BENCH_CHAIN 4
+
+typedef struct Bench_Scene
+{
+    const char* name;
+    void (*draw)(int frame);
+    // Staged each frame, for the throughput
+    int sprites;
+} Bench_Scene;
+
+static SDL_GPUGraphicsPipeline* pipeline = NULL;
+// Stands in for the screen, which a headless TinyDraw doesn't have
+static SDL_GPUTexture* target = NULL;
+static SDL_GPUTexture* textures[BENCH_TEXTURES] = { 0 };
+static Tilemap* tilemap = NULL;
+static SpriteDesc* descs = NULL;
+
+static const float3 camera = { .x = 0, .y = 0, .z = 1.0f };
+
+/**
+ * Same sequence on every run & platform, unlike `SDL_rand`.
+ */
+static Uint32 Random(Uint32* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static void Fill_Sprites(void)
+{
+    Uint32 state = 1;
+    for (int i = 0; i < BENCH_SPRITES; i++) {
+        descs[i] = (SpriteDesc) {
+            .destPos = {
+                .x = (float) (Random(&state) % BENCH_WIDTH),
+                .y = (float) (Random(&state) % BENCH_HEIGHT),
+            },
+            .destSize = { .x = 16, .y = 16 },
+            .sourcePos = { .x = 0, .y = 0 },
+            .sourceSize = { .x = 0.25f, .y = 0.25f },
+            .color = { 1, 1, 1, 1 },
+        };
+    }
+}
+
+/**
+ * A checkerboard, tinted differently for each texture.
+ */
+static SDL_GPUTexture* Create_Texture(int index)
+{
+    Uint8 pixels[BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE * 4];
+    for (int y = 0; y < BENCH_TEXTURE_SIZE; y++) {
+        for (int x = 0; x < BENCH_TEXTURE_SIZE; x++) {
+            Uint8* pixel = &pixels[(y * BENCH_TEXTURE_SIZE + x) * 4];
+            const Uint8 shade = ((x / 8 + y / 8) & 1) ? 255 : 128;
+            pixel[0] = shade;
+            pixel[1] = (Uint8) (shade * index / BENCH_TEXTURES);
+            pixel[2] = (Uint8) (shade - shade * index / BENCH_TEXTURES);
+            pixel[3] = 255;
+        }
+    }
+    
+    return Texture_Upload(
+        SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        BENCH_TEXTURE_SIZE,
+        BENCH_TEXTURE_SIZE,
+        1,
+        pixels
+    );
+}
+
+static void Draw_Sprites(int count)
+{
+    TinyDraw_Stage_Sprites(textures[0], descs, count);
+    TinyDraw_Render(pipeline, camera, target, 1);
+}
+
+static void Draw_1k(int frame)
+{
+    (void) frame;
+    Draw_Sprites(1000);
+}
+
+static void Draw_10k(int frame)
+{
+    (void) frame;
+    Draw_Sprites(10000);
+}
+
+static void Draw_100k(int frame)
+{
+    (void) frame;
+    Draw_Sprites(100000);
+}
+
+/**
+ * Neighbouring sprites never share a texture, so only sorting keeps the
+ * draw calls down to one per texture.
+ */
+static void Draw_Textures(int frame)
+{
+    (void) frame;
+    for (int i = 0; i < 10000; i++) {
+        TinyDraw_Stage_Sprite(
+            textures[i % BENCH_TEXTURES],
+            descs[i].destPos,
+            descs[i].destSize,
+            descs[i].sourcePos,
+            descs[i].sourceSize,
+            descs[i].color
+        );
+    }
+    TinyDraw_Render(pipeline, camera, target, 1);
+}
+
+/**
+ * Scrolls diagonally across the map, so chunks keep entering the view.
+ */
+static void Draw_Tilemap(int frame)
+{
+    const float scroll = (float) (frame % 1024) * 2.0f;
+    const float3 view = { .x = scroll, .y = scroll * 0.5f, .z = 1.0f };
+    TinyDraw_Stage_Tilemap(tilemap, view, target);
+    TinyDraw_Render(pipeline, view, target, 1);
+}
+
+/**
+ * 1k sprites drawn into a transient target, which is drawn into the next,
+ * down a chain of `BENCH_CHAIN` targets & finally into `target`.
+ */
+static void Draw_Chain(int frame)
+{
+    (void) frame;
+    SDL_GPUTexture* previous = TinyDraw_Get_Transient_Target(BENCH_WIDTH, BENCH_HEIGHT);
+    TinyDraw_Stage_Sprites(textures[0], descs, 1000);
+    TinyDraw_Render(pipeline, camera, previous, 1);
+    
+    for (int i = 1; i <= BENCH_CHAIN; i++) {
+        SDL_GPUTexture* next = i < BENCH_CHAIN
+            ? TinyDraw_Get_Transient_Target(BENCH_WIDTH, BENCH_HEIGHT)
+            : target;
+        TinyDraw_Stage_Sprite(
+            previous,
+            (float2){ .x = 0, .y = 0 },
+            (float2){ .x = BENCH_WIDTH, .y = BENCH_HEIGHT },
+            (float2){ .x = 0, .y = 0 },
+            (float2){ .x = 1, .y = 1 },
+            (Color){ 1, 1, 1, 1 }
+        );
+        TinyDraw_Render(pipeline, camera, next, 1);
+        previous = next;
+    }
+}
+
+static int Compare_Ticks(const void* a, const void* b)
+{
+    const Uint64 x = *(const Uint64*) a;
+    const Uint64 y = *(const Uint64*) b;
+    return (x > y) - (x < y);
+}
+
+static void Run(const Bench_Scene* scene)
+{
+    static Uint64 ticks[BENCH_FRAMES];
+    Uint64 total = 0;
+    double flushTime = 0;
+    
+    for (int frame = 0; frame < BENCH_WARMUP + BENCH_FRAMES; frame++) {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        TinyDraw_BeginFrame();
+        scene->draw(frame);
+        TinyDraw_EndFrame();
+        SDL_WaitForGPUIdle(device);
+        const Uint64 end = SDL_GetPerformanceCounter();
+        
+        if (frame >= BENCH_WARMUP) {
+            ticks[frame - BENCH_WARMUP] = end - start;
+            total += end - start;
+            flushTime += TinyDraw_Get_Frame_Stats().flushTime;
+        }
+    }
+    SDL_qsort(ticks, BENCH_FRAMES, sizeof(Uint64), Compare_Ticks);
+    
+    const double tickTime = 1000.0 / (double) SDL_GetPerformanceFrequency();
+    const double seconds = total * tickTime / 1000.0;
+    const FrameStats stats = TinyDraw_Get_Frame_Stats();
+    SDL_Log(
+        "%-12s p50 %7.3f  p90 %7.3f  p99 %7.3f  max %7.3f ms  %8.2f M sprites/s  "
+        "flush %6.3f ms  %4d draws  %2d passes  %7d KB",
+        scene->name,
+        ticks[BENCH_FRAMES / 2] * tickTime,
+        ticks[BENCH_FRAMES * 9 / 10] * tickTime,
+        ticks[BENCH_FRAMES * 99 / 100] * tickTime,
+        ticks[BENCH_FRAMES - 1] * tickTime,
+        (double) scene->sprites * BENCH_FRAMES / seconds / 1000000.0,
+        flushTime / BENCH_FRAMES,
+        stats.drawCalls,
+        stats.renderPasses,
+        (int) (stats.uploadBytes / 1024)
+    );
+}
+
+int main(void)
+{
+    if (!TinyDraw_Init_Headless()) {
+        return 1;
+    }
+    TinyDraw_Set_Resolution(BENCH_WIDTH, BENCH_HEIGHT, 0);
+    
+    SDL_GPUShader* vertexShader = TinyDraw_Load_Shader("sprite.vert", 0, 1, 0, 0, SDL_GPU_SHADERSTAGE_VERTEX);
+    SDL_GPUShader* fragmentShader = TinyDraw_Load_Shader("sprite.frag", 1, 0, 0, 0, SDL_GPU_SHADERSTAGE_FRAGMENT);
+    if (vertexShader == NULL || fragmentShader == NULL) {
+        return 1;
+    }
+    pipeline = TinyDraw_Create_Pipeline(vertexShader, fragmentShader);
+    target = TinyDraw_Create_RenderTarget(BENCH_WIDTH, BENCH_HEIGHT);
+    
+    for (int i = 0; i < BENCH_TEXTURES; i++) {
+        textures[i] = Create_Texture(i);
+    }
+    
+    const int2 tilesetSize = { .x = BENCH_TEXTURE_SIZE, .y = BENCH_TEXTURE_SIZE };
+    const int2 tileSize = { .x = BENCH_TILE_SIZE, .y = BENCH_TILE_SIZE };
+    tilemap = TinyDraw_Create_Tilemap(textures[1], tilesetSize, tileSize, BENCH_MAP_SIZE, BENCH_MAP_SIZE);
+    
+    descs = SDL_malloc(sizeof(SpriteDesc) * BENCH_SPRITES);
+    if (pipeline == NULL || target == NULL || tilemap == NULL || descs == NULL) {
+        SDL_Log("Failed to set up the benchmark");
+        return 1;
+    }
+    Fill_Sprites();
+    
+    Uint32 state = 2;
+    for (int y = 0; y < BENCH_MAP_SIZE; y++) {
+        for (int x = 0; x < BENCH_MAP_SIZE; x++) {
+            TinyDraw_Set_Tile(tilemap, x, y, (int) (Random(&state) % 16));
+        }
+    }
+    
+    // Tiles seen at once, for the tilemap's throughput
+    const int tiles = (BENCH_WIDTH / BENCH_TILE_SIZE + 1) * (BENCH_HEIGHT / BENCH_TILE_SIZE + 1);
+    const Bench_Scene scenes[] = {
+        { "1k", Draw_1k, 1000 },
+        { "10k", Draw_10k, 10000 },
+        { "100k", Draw_100k, 100000 },
+        { "textures", Draw_Textures, 10000 },
+        { "tilemap", Draw_Tilemap, tiles },
+        { "chain", Draw_Chain, 1000 + BENCH_CHAIN },
+    };
+    
+    SDL_Log(
+        "%dx%d, %d frames after %d to warm up, flush needs TINYDRAW_PROFILE",
+        BENCH_WIDTH,
+        BENCH_HEIGHT,
+        BENCH_FRAMES,
+        BENCH_WARMUP
+    );
+    for (int i = 0; i < (int) SDL_arraysize(scenes); i++) {
+        Run(&scenes[i]);
+    }
+    
+    SDL_free(descs);
+    TinyDraw_Destroy_Tilemap(tilemap);
+    for (int i = 0; i < BENCH_TEXTURES; i++) {
+        TinyDraw_Unload_Texture(textures[i]);
+    }
+    TinyDraw_Unload_Texture(target);
+    TinyDraw_Destroy_Pipeline(pipeline);
+    TinyDraw_Unload_Shader(fragmentShader);
+    TinyDraw_Unload_Shader(vertexShader);
+    
+    TinyDraw_Quit();
+    
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Micro-benchmark of sprite staging & the CPU side of a flush, without a GPU.
+//
+// Times the per-call path (`TinyDraw_Stage_Sprite` for each sprite) against
+// `TinyDraw_Stage_Sprites`, & the flush (cull, sort & pack into vertices)
+// with every quad kernel compiled in. The world scene spreads the sprites
+// over 16 screens with culling on. Run with `make bench-quads`.
+
+#define TINYDRAW_IMPLEMENTATION
+#include "tinydraw.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC SDL_malloc
+#define STBI_REALLOC SDL_realloc
+#define STBI_FREE SDL_free
+#include "vendor/stb_image.h"
+
+#define BENCH_SPRITES (1 << 20)
+#define BENCH_ROUNDS 10
+
+static SpriteDesc* descs = NULL;
+static Vertex* vertices = NULL;
+// Only compared against, never dereferenced
+static SDL_GPUTexture* texture = (SDL_GPUTexture*) &descs;
+
+static void Stage_PerCall(void)
+{
+    for (int i = 0; i < BENCH_SPRITES; i++) {
+        TinyDraw_Stage_Sprite(
+            texture,
+            descs[i].destPos,
+            descs[i].destSize,
+            descs[i].sourcePos,
+            descs[i].sourceSize,
+            descs[i].color
+        );
+    }
+}
+
+static void Stage_Bulk(void)
+{
+    TinyDraw_Stage_Sprites(texture, descs, BENCH_SPRITES);
+}
+
+static void Fill_Scene(int screens)
+{
+    for (int i = 0; i < BENCH_SPRITES; i++) {
+        descs[i] = (SpriteDesc) {
+            .destPos = {
+                .x = (float) ((i * 7) % (sizeGame.x * screens)),
+                .y = (float) ((i * 13) % (sizeGame.y * screens)),
+            },
+            .destSize = { .x = 8, .y = 8 },
+            .sourcePos = { .x = 0.25f, .y = 0.5f },
+            .sourceSize = { .x = 0.25f, .y = 0.25f },
+            .color = { 1, 1, 1, 1 },
+        };
+    }
+}
+
+static void Run(const char* name, void (*stage)(void), SpriteBatch_Quad_Kernel kernel)
+{
+    Uint64 bestStage = SDL_MAX_UINT64;
+    Uint64 bestFlush = SDL_MAX_UINT64;
+    int drawn = 0;
+    spriteBatchWriteQuads = kernel;
+    
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        SpriteBatch_Reset();
+        
+        const Uint64 start = SDL_GetPerformanceCounter();
+        stage();
+        SpriteBatch_Record_View(NULL, (float3){ 0 }, NULL, 1, -1);
+        const Uint64 staged = SDL_GetPerformanceCounter();
+        if (cullEnabled) {
+            SpriteBatch_Cull();
+        }
+        SpriteBatch_Sort();
+        SpriteBatch_Pack(vertices, NULL, NULL);
+        const Uint64 flushed = SDL_GetPerformanceCounter();
+        
+        bestStage = SDL_min(bestStage, staged - start);
+        bestFlush = SDL_min(bestFlush, flushed - staged);
+        drawn = batchVertexSpriteCount;
+    }
+    
+    const double perMillion = 1000.0 * 1000000.0 / BENCH_SPRITES / SDL_GetPerformanceFrequency();
+    SDL_Log(
+        "%-20s stage %8.3f ms, flush %8.3f ms per million sprites, %d drawn",
+        name,
+        bestStage * perMillion,
+        bestFlush * perMillion,
+        drawn
+    );
+}
+
+static void Run_Kernels(void)
+{
+    Run("per-call + scalar", Stage_PerCall, SpriteBatch_Write_Quads_Scalar);
+    Run("bulk + scalar", Stage_Bulk, SpriteBatch_Write_Quads_Scalar);
+#ifdef SDL_SSE2_INTRINSICS
+    if (SDL_HasSSE2()) {
+        Run("bulk + SSE2", Stage_Bulk, SpriteBatch_Write_Quads_SSE2);
+    }
+#endif
+#ifdef SDL_NEON_INTRINSICS
+    if (SDL_HasNEON()) {
+        Run("bulk + NEON", Stage_Bulk, SpriteBatch_Write_Quads_NEON);
+    }
+#endif
+}
+
+int main(void)
+{
+    descs = SDL_malloc(sizeof(SpriteDesc) * BENCH_SPRITES);
+    vertices = SDL_malloc(sizeof(Vertex) * 4 * BENCH_SPRITES);
+    if (descs == NULL || vertices == NULL || !SpriteBatch_Grow(BENCH_SPRITES)) {
+        SDL_Log("Failed to allocate benchmark buffers");
+        return 1;
+    }
+    
+    SDL_Log("%d sprites, best of %d rounds", BENCH_SPRITES, BENCH_ROUNDS);
+    
+    SDL_Log("On screen, no culling:");
+    Fill_Scene(1);
+    TinyDraw_Set_Culling(0, 0);
+    Run_Kernels();
+    
+    SDL_Log("World of 4x4 screens, culled:");
+    Fill_Scene(4);
+    TinyDraw_Set_Culling(1, 0);
+    Run_Kernels();
+    
+    SDL_free(vertices);
+    SDL_free(descs);
+    
+    return 0;
+}
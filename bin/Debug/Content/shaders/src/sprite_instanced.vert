@@ -0,0 +1,27 @@
+#version 450
+
+layout (location = 0) in vec4 Rect;
+layout (location = 1) in vec4 Source;
+layout (location = 2) in vec4 Color;
+layout (location = 0) out vec2 outTexCoord;
+layout (location = 1) out vec4 outColor;
+
+layout (set = 1, binding = 0) uniform UniformBlock
+{
+	mat4x4 MatrixTransform;
+};
+
+// Corners of the quad for each of the 6 vertices, matching the index order
+// of the non-instanced sprite batch
+const vec2 Corners[6] = vec2[6](
+	vec2(0, 0), vec2(1, 0), vec2(1, 1),
+	vec2(0, 0), vec2(1, 1), vec2(0, 1)
+);
+
+void main()
+{
+	vec2 corner = Corners[gl_VertexIndex];
+	outColor = Color;
+	outTexCoord = Source.xy + Source.zw * corner;
+	gl_Position = MatrixTransform * vec4(Rect.xy + Rect.zw * corner, 0, 1);
+}
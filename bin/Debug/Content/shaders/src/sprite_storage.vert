@@ -0,0 +1,43 @@
+#version 450
+
+layout (location = 0) out vec2 outTexCoord;
+layout (location = 1) out vec4 outColor;
+
+// `SpriteInstance`s, 7 words each: x, y, w, h, (u, v), (uw, vh), rgba
+layout (std430, set = 0, binding = 0) readonly buffer SpriteBuffer
+{
+	uint Sprites[];
+};
+
+layout (set = 1, binding = 0) uniform UniformBlock
+{
+	mat4x4 MatrixTransform;
+};
+
+layout (set = 1, binding = 1) uniform DrawBlock
+{
+	uint FirstSprite;
+};
+
+// Corners of the quad for each of the 6 vertices, matching the index order
+// of the non-instanced sprite batch
+const vec2 Corners[6] = vec2[6](
+	vec2(0, 0), vec2(1, 0), vec2(1, 1),
+	vec2(0, 0), vec2(1, 1), vec2(0, 1)
+);
+
+void main()
+{
+	uint base = (FirstSprite + gl_VertexIndex / 6) * 7;
+	vec2 corner = Corners[gl_VertexIndex % 6];
+	vec4 rect = vec4(
+		uintBitsToFloat(Sprites[base + 0]),
+		uintBitsToFloat(Sprites[base + 1]),
+		uintBitsToFloat(Sprites[base + 2]),
+		uintBitsToFloat(Sprites[base + 3])
+	);
+	vec4 source = vec4(unpackUnorm2x16(Sprites[base + 4]), unpackUnorm2x16(Sprites[base + 5]));
+	outColor = unpackUnorm4x8(Sprites[base + 6]);
+	outTexCoord = source.xy + source.zw * corner;
+	gl_Position = MatrixTransform * vec4(rect.xy + rect.zw * corner, 0, 1);
+}
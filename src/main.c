@@ -16,6 +16,7 @@ int main(void)
     if (!TinyDraw_Init()) {
         return 1;
     }
+    TinyDraw_Set_Frame_Pacing(60, 2);
     
     SDL_GPUShader* vertexShader = TinyDraw_Load_Shader("sprite.vert", 0, 1, 0, 0, SDL_GPU_SHADERSTAGE_VERTEX);
     if (vertexShader == NULL)
@@ -36,7 +37,15 @@ int main(void)
     SDL_GPUTexture* texture = TinyDraw_Load_Texture("paving 1.png", NULL, NULL);
     SDL_GPUTexture* texture2 = TinyDraw_Load_Texture("tiles_tiny_sample_2.png", NULL, NULL);
     
-    SDL_GPUTexture* renderTarget = TinyDraw_Create_RenderTarget(160, 90);
+    float tilesize = 25;
+    TinyDraw_Stage_Sprite(
+        texture2,
+        (float2){ .x = 0, .y = 48 },
+        (float2){ .x = tilesize, .y = tilesize },
+        FRAME(0, 1, tilesize, tilesize, 250.0f, 250.0f),
+        (Color){ 1, 1, 1, 1 }
+    );
+    StaticLayer* tiles = TinyDraw_Bake_StaticLayer();
     
     float X = 64, Y = 0;
     
@@ -73,43 +82,45 @@ int main(void)
         // camX += 0.1f;
         // camY += 0.1f;
         
+        TinyDraw_BeginFrame();
+        
+        // The world at its native resolution, upscaled once to the screen
+        SDL_GPUTexture* renderTarget = TinyDraw_Get_Transient_Target(160, 90);
+        
         // Clear
         TinyDraw_Clear(renderTarget);
         
-        float tilesize = 25;
-        TinyDraw_Stage_Sprite(
-            (float2){ .x = 0, .y = 48 },
-            (float2){ .x = tilesize, .y = tilesize },
-            FRAME(0, 1, tilesize, tilesize, 250.0f, 250.0f),
-            (Color){ 1, 1, 1, 1 }
-        );
-        TinyDraw_Render(pipeline, texture2, (float3){ .x = camX, .y = camY, .z = 1.0f }, renderTarget, 0);
+        TinyDraw_Stage_StaticLayer(tiles);
         
-        TinyDraw_Stage_Sprite(
+        TinyDraw_Stage_Sprite_Ex(
+            NULL,
+            texture,
+            1,
             (float2){ .x = X, .y = Y },
             (float2){ .x = 64, .y = 64 },
             (float2){ .x = 0, .y = 0 },
             (float2){ .x = 1, .y = 1 },
             (Color){ 1, 1, 1, 1 }
         );
-        TinyDraw_Render(pipeline, texture, (float3){ .x = camX, .y = camY, .z = 1.0f }, renderTarget, 0);
+        TinyDraw_Render(pipeline, (float3){ .x = camX, .y = camY, .z = 1.0f }, renderTarget, 0);
         
         TinyDraw_Stage_Sprite(
+            renderTarget,
             (float2){ .x = 0, .y = 0 },
             (float2){ .x = 160, .y = 90 },
             (float2){ .x = 0, .y = 0 },
             (float2){ .x = 1, .y = 1 },
             (Color){ 1, 1, 1, 1 }
         );
-        TinyDraw_Render(pipeline, renderTarget, (float3){ .x = 0, .y = 0, .z = 1.0f }, NULL, 1);
+        TinyDraw_Render(pipeline, (float3){ .x = 0, .y = 0, .z = 1.0f }, NULL, 1);
         
-        // Sleep until next frame
-        SDL_Delay(1000 / 60);
+        // Also waits until the next frame
+        TinyDraw_EndFrame();
     }
     
+    TinyDraw_Destroy_StaticLayer(tiles);
     TinyDraw_Destroy_Pipeline(pipeline);
     
-    TinyDraw_Unload_Texture(renderTarget);
     TinyDraw_Unload_Texture(texture);
     TinyDraw_Unload_Texture(texture2);
     TinyDraw_Unload_Shader(fragmentShader);
@@ -28,6 +28,33 @@ SOFTWARE.
 
 #define TINYDRAW_VERSION "v0.0.1"
 
+// Texture packs written by `make bake`, see `TinyDraw_Load_Pack`
+#define TINYDRAW_PACK_MAGIC 0x4B504454 // "TDPK"
+#define TINYDRAW_PACK_VERSION 1
+#define TINYDRAW_PACK_FORMAT_RGBA8 0
+#define TINYDRAW_PACK_FORMAT_BC1 1
+#define TINYDRAW_PACK_FORMAT_BC3 2
+#define TINYDRAW_PACK_FORMAT_BC7 3
+#define TINYDRAW_PACK_NAME_LENGTH 64
+
+// Sampler filters & address modes, see `TinyDraw_Get_Sampler`
+#define TINYDRAW_FILTER_NEAREST 0
+#define TINYDRAW_FILTER_LINEAR 1
+#define TINYDRAW_ADDRESS_CLAMP 0
+#define TINYDRAW_ADDRESS_REPEAT 1
+#define TINYDRAW_ADDRESS_MIRROR 2
+
+// States of a texture loaded with `TinyDraw_Load_Texture_Async`
+#define TINYDRAW_LOAD_FAILED -1
+#define TINYDRAW_LOAD_PENDING 0
+#define TINYDRAW_LOAD_READY 1
+
+// Most frames `TinyDraw_Set_Frame_Pacing` lets the GPU work on at once
+#define TINYDRAW_FRAMES_IN_FLIGHT_MAX 3
+
+// Most readbacks waiting on the GPU, see `TinyDraw_Read_RenderTarget`
+#define TINYDRAW_READBACK_MAX 4
+
 // Types
 
 typedef struct int2
@@ -69,6 +96,134 @@ typedef struct Vertex
     float r, g, b, a;
 } Vertex;
 
+// One sprite for instanced pipelines, expanded into a quad by the vertex
+// shader. Source rect & color are normalized integers.
+typedef struct SpriteInstance
+{
+    float x, y;
+    float w, h;
+    Uint16 u, v, uw, vh;
+    Uint8 r, g, b, a;
+} SpriteInstance;
+
+// One sprite for `TinyDraw_Stage_Sprites`, with the same fields as the
+// arguments of `TinyDraw_Stage_Sprite`
+typedef struct SpriteDesc
+{
+    float2 destPos;
+    float2 destSize;
+    float2 sourcePos;
+    float2 sourceSize;
+    Color color;
+} SpriteDesc;
+
+// Sprites baked once into their own GPU vertex buffer, see
+// `TinyDraw_Bake_StaticLayer`
+typedef struct StaticLayer StaticLayer;
+
+// Grid of tiles drawn from a tileset, see `TinyDraw_Create_Tilemap`
+typedef struct Tilemap Tilemap;
+
+// Sprites staged from one worker thread, see `TinyDraw_Create_StagingContext`
+typedef struct StagingContext StagingContext;
+
+// Texture decoding in the background, see `TinyDraw_Load_Texture_Async`
+typedef struct TextureLoad TextureLoad;
+
+// A texture pack is a `PackHeader`, `textureCount` `PackTexture`s,
+// `regionCount` `PackRegion`s & the texel data, all little endian. Every
+// texture's mip levels are stored back to back from `offset`, largest first,
+// ready to be copied into a transfer buffer as is.
+typedef struct PackHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 textureCount;
+    Uint32 regionCount;
+    // Where the texel data of the first texture starts
+    Uint64 dataOffset;
+    Uint64 dataSize;
+} PackHeader;
+
+typedef struct PackTexture
+{
+    Uint32 width;
+    Uint32 height;
+    Uint32 levelCount;
+    Uint32 format;
+    Uint64 offset;
+    Uint64 size;
+} PackTexture;
+
+// A named rect on one of the pack's textures
+typedef struct PackRegion
+{
+    char name[TINYDRAW_PACK_NAME_LENGTH];
+    Uint32 texture;
+    Uint32 width;
+    Uint32 height;
+    float2 sourcePos;
+    float2 sourceSize;
+} PackRegion;
+
+// Textures loaded from a texture pack, see `TinyDraw_Load_Pack`
+typedef struct TexturePack TexturePack;
+
+// Images packed into shared texture pages, see `TinyDraw_Create_Atlas`
+typedef struct Atlas Atlas;
+
+// Where an image ended up in an atlas. `sourcePos` & `sourceSize` go straight
+// into `TinyDraw_Stage_Sprite`, together with `texture`.
+typedef struct AtlasRegion
+{
+    SDL_GPUTexture* texture;
+    float2 sourcePos;
+    float2 sourceSize;
+    // In pixels
+    int2 size;
+} AtlasRegion;
+
+// What one frame cost, see `TinyDraw_Get_Frame_Stats`. Timings are CPU time
+// in milliseconds & stay 0 unless TinyDraw is compiled with
+// `TINYDRAW_PROFILE` defined.
+typedef struct FrameStats
+{
+    // Recorded by a `TinyDraw_Render`, culled ones included
+    int spritesStaged;
+    int spritesCulled;
+    int drawCalls;
+    int renderPasses;
+    int commandBuffers;
+    // Copied from transfer buffers to buffers & textures
+    Uint64 uploadBytes;
+    int textureBinds;
+    int pipelineBinds;
+    // In the `TinyDraw_Stage_*` functions, on the render thread
+    double stageTime;
+    // Recording `TinyDraw_Render` & `TinyDraw_Redraw`, merging staging
+    // contexts included
+    double renderTime;
+    // Culling, sorting, packing & uploading sprites in `TinyDraw_EndFrame`
+    double flushTime;
+    // From acquiring the swapchain to submitting the frame
+    double submitTime;
+    // Always measured: from the start of the latest frame the GPU finished,
+    // when its input was read, to TinyDraw seeing it finished. Fences are
+    // only checked in `TinyDraw_BeginFrame` & `TinyDraw_EndFrame`, so it
+    // comes in steps of those & may include time after the present.
+    double latency;
+} FrameStats;
+
+// Receives the pixels of `TinyDraw_Read_RenderTarget`, `width` * 4 bytes per
+// row in `format`. The pixels are only valid during the call.
+typedef void (*ReadbackCallback)(
+    void* userdata,
+    const Uint8* pixels,
+    int width,
+    int height,
+    SDL_GPUTextureFormat format
+);
+
 // Function Declarations
 
 /**
@@ -79,6 +234,17 @@ typedef struct Vertex
  */
 int TinyDraw_Init(void);
 
+/**
+ * Initializes SDL3 & SDL_GPU without a window, for benchmarks & hosts without
+ * a display, e.g. on a software Vulkan driver like lavapipe. Only render
+ * targets are drawn: renders to the screen are recorded but dropped, &
+ * `TinyDraw_Resize` does nothing.
+ *
+ * @return  int truthy for success, falsy for failure. Logs to console on
+ *              failure as well.
+ */
+int TinyDraw_Init_Headless(void);
+
 /**
  * Resize window & go in or out of fullscreen.
  *
@@ -93,16 +259,54 @@ void TinyDraw_Resize(int width, int height, char fullscreen);
  *
  * Returns an `SDL_GPUTexture*`. Destroy with `TinyDraw_Unload_Texture`.
  *
+ * Its size is also its virtual resolution: a camera rendering to it sees
+ * `width` x `height` world units at a zoom of 1.
+ *
  * @param   int             width
  * @param   int             height
  *
- * @return  SDL_GPUTexture*
+ * @return  SDL_GPUTexture* `NULL` if 256 render targets are alive already
  */
 SDL_GPUTexture* TinyDraw_Create_RenderTarget(int width, int height);
 
+/**
+ * Set the virtual resolution of the screen: a camera rendering to it sees
+ * `width` x `height` world units at a zoom of 1, scaled up to the window &
+ * centered with black bars. With `integerScale` every world unit covers the
+ * same whole number of pixels; otherwise the largest fitting scale is used.
+ *
+ * Defaults to 160 x 90, integer scaled.
+ *
+ * @param   int     width
+ * @param   int     height
+ * @param   char    integerScale
+ */
+void TinyDraw_Set_Resolution(int width, int height, char integerScale);
+
+/**
+ * Get a render target that only lives until the end of the frame, for
+ * intermediate results such as a low resolution world later drawn to the
+ * screen. Only pass it to `TinyDraw_Render`, `TinyDraw_Clear` & the staging
+ * functions, & only until `TinyDraw_EndFrame`.
+ *
+ * Its contents start undefined & are dropped after the last render sampling
+ * it, so they are never loaded or stored. Transient targets of the same
+ * size whose render passes don't overlap share one texture.
+ *
+ * @param   int             width
+ * @param   int             height
+ *
+ * @return  SDL_GPUTexture* `NULL` if too many were asked for this frame
+ */
+SDL_GPUTexture* TinyDraw_Get_Transient_Target(int width, int height);
+
 /**
  * Create a Pipeline. They are associated with a vertex & fragment shader.
  *
+ * Pipelines are shared: creating one again from the same shaders, kind &
+ * depth setting returns the existing pipeline, so every creation needs its
+ * own `TinyDraw_Destroy_Pipeline`.
+ *
  * @param   SDL_GPUShader*  vertexShader
  * @param   SDL_GPUShader*  fragmentShader
  *
@@ -113,9 +317,82 @@ SDL_GPUGraphicsPipeline* TinyDraw_Create_Pipeline(
     SDL_GPUShader* fragmentShader
 );
 
+/**
+ * Create an instanced Pipeline. Sprites drawn with it are uploaded as one
+ * `SpriteInstance` each instead of four `Vertex`es & six indices, and the
+ * vertex shader expands the quad from `gl_VertexIndex` (see
+ * `sprite_instanced.vert`). Source rects are clamped to 0..1, so textures
+ * don't tile with a repeating sampler.
+ *
+ * @param   SDL_GPUShader*  vertexShader
+ * @param   SDL_GPUShader*  fragmentShader
+ *
+ * @return  SDL_GPUGraphicsPipeline*
+ */
+SDL_GPUGraphicsPipeline* TinyDraw_Create_Instanced_Pipeline(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader
+);
+
+/**
+ * Create a storage Pipeline. It has no vertex input: sprites drawn with it
+ * are uploaded as `SpriteInstance`s into a read-only storage buffer, which
+ * the vertex shader indexes with `gl_VertexIndex / 6` (see
+ * `sprite_storage.vert`). No index buffer is used.
+ *
+ * The vertex shader takes the storage buffer in slot 0 & a second uniform
+ * buffer holding the draw's first sprite, so load it with
+ * `uniformBufferCount = 2` & `storageBufferCount = 1`.
+ *
+ * @param   SDL_GPUShader*  vertexShader
+ * @param   SDL_GPUShader*  fragmentShader
+ *
+ * @return  SDL_GPUGraphicsPipeline*
+ */
+SDL_GPUGraphicsPipeline* TinyDraw_Create_Storage_Pipeline(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader
+);
+
+/**
+ * Give every render pass a depth buffer. Sprites are placed in depth by
+ * their layer, higher layers in front, & every pipeline tests against it, so
+ * opaque sprites hide what they cover before it is shaded. Instanced &
+ * storage sprites have no depth & are drawn in front of opaque ones.
+ *
+ * Pipelines are created for one or the other, so call this before creating
+ * any. Off by default.
+ *
+ * @param   char    enabled
+ */
+void TinyDraw_Set_Depth(char enabled);
+
+/**
+ * Create an opaque Pipeline, taking the same shaders & `Vertex` input as
+ * `TinyDraw_Create_Pipeline`, with blending off & depth writes on. Needs
+ * `TinyDraw_Set_Depth`.
+ *
+ * Its sprites are drawn before the rest of their render, front to back, so
+ * the sprites & tiles they cover are rejected by the depth test instead of
+ * being blended over. Only use it for sprites without transparent pixels.
+ *
+ * @param   SDL_GPUShader*  vertexShader
+ * @param   SDL_GPUShader*  fragmentShader
+ *
+ * @return  SDL_GPUGraphicsPipeline*
+ */
+SDL_GPUGraphicsPipeline* TinyDraw_Create_Opaque_Pipeline(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader
+);
+
 /**
  * Load a shader file with the given parameters.
  *
+ * Backends other than Vulkan need the SPIR-V translated. On Metal & Direct3D
+ * the translation is cached in the user's preferences folder, keyed by a
+ * hash of the SPIR-V, so it only runs once per shader & backend.
+ *
  * @param   char*               filename            under `./Content/shaders/`
  * @param   Uint32              samplerCount
  * @param   Uint32              uniformBufferCount
@@ -137,6 +414,10 @@ SDL_GPUShader* TinyDraw_Load_Shader(
 /**
  * Load a texture file.
  *
+ * PNGs & other images are decoded to RGBA. DDS files holding BC1, BC3 or BC7
+ * are uploaded as is, with their mip levels, which takes 4 to 8 times less
+ * memory & bandwidth.
+ *
  * Optionally output the width & height of the texture.
  *
  * @param   char*   filename    under `./Content/sprites/`
@@ -151,16 +432,153 @@ SDL_GPUTexture* TinyDraw_Load_Texture(
     int* height
 );
 
+/**
+ * Start loading a texture file without blocking. The image is decoded on a
+ * pool of worker threads, started by the first call, & uploaded by a later
+ * `TinyDraw_BeginFrame` in the same copy pass as every other texture
+ * decoded by then.
+ *
+ * Finish every load with `TinyDraw_Finish_Texture_Load` before
+ * `TinyDraw_Quit`.
+ *
+ * @param   char*           filename    under `./Content/sprites/`
+ *
+ * @return  TextureLoad*    `NULL` on failure
+ */
+TextureLoad* TinyDraw_Load_Texture_Async(const char* fileName);
+
+/**
+ * @param   TextureLoad*    load
+ *
+ * @return  int `TINYDRAW_LOAD_READY` once the texture's upload has been
+ *              recorded, so it can be drawn this frame,
+ *              `TINYDRAW_LOAD_PENDING` before that or `TINYDRAW_LOAD_FAILED`
+ */
+int TinyDraw_Poll_Texture_Load(TextureLoad* load);
+
+/**
+ * Take the texture out of a load & free the load. Blocks until the image is
+ * decoded & uploads it right away if it isn't ready yet.
+ *
+ * @param   TextureLoad*    load
+ * @param   int*            width       pointer to write to, or `NULL`
+ * @param   int*            height      pointer to write to, or `NULL`
+ *
+ * @return  SDL_GPUTexture* `NULL` if the load failed
+ */
+SDL_GPUTexture* TinyDraw_Finish_Texture_Load(
+    TextureLoad* load,
+    int* width,
+    int* height
+);
+
+/**
+ * Create an empty atlas. Images added to it are packed into square pages,
+ * so sprites from different images can share a texture & a draw call.
+ *
+ * Every image is surrounded by `padding` pixels repeating its edges, so
+ * filtering & rounding at the edge of a sprite never pick up its neighbors.
+ *
+ * @param   int     pageSize    width & height of every page in pixels
+ * @param   int     padding     in pixels
+ *
+ * @return  Atlas*  `NULL` on failure
+ */
+Atlas* TinyDraw_Create_Atlas(int pageSize, int padding);
+
+/**
+ * Pack a texture file into an atlas. Call `TinyDraw_Upload_Atlas` before
+ * drawing it.
+ *
+ * @param   Atlas*          atlas
+ * @param   char*           filename    under `./Content/sprites/`
+ * @param   AtlasRegion*    region      written on success
+ *
+ * @return  int truthy for success, falsy for failure
+ */
+int TinyDraw_Add_Atlas_Image(Atlas* atlas, const char* fileName, AtlasRegion* region);
+
+/**
+ * Pack RGBA pixels into an atlas. The pixels are copied, so they can be
+ * freed right away.
+ *
+ * @param   Atlas*          atlas
+ * @param   const Uint8*    pixels  `width` * `height` RGBA pixels, row by row
+ * @param   int             width
+ * @param   int             height
+ * @param   AtlasRegion*    region  written on success
+ *
+ * @return  int truthy for success, falsy for failure
+ */
+int TinyDraw_Add_Atlas_Pixels(
+    Atlas* atlas,
+    const Uint8* pixels,
+    int width,
+    int height,
+    AtlasRegion* region
+);
+
+/**
+ * Upload everything added to an atlas since its last upload, in one copy
+ * pass. Between `TinyDraw_BeginFrame` & `TinyDraw_EndFrame` the copy is
+ * recorded into the frame, otherwise it is submitted right away.
+ *
+ * @param   Atlas*  atlas
+ */
+void TinyDraw_Upload_Atlas(Atlas* atlas);
+
+/**
+ * Release the atlas & its page textures.
+ *
+ * @param   Atlas*  atlas
+ */
+void TinyDraw_Destroy_Atlas(Atlas* atlas);
+
+/**
+ * Load a texture pack baked by `make bake`. Texel data is read from the file
+ * straight into one transfer buffer, without decoding, & every texture is
+ * uploaded in the same copy pass.
+ *
+ * @param   char*           filename    under `./Content/`
+ *
+ * @return  TexturePack*    `NULL` on failure
+ */
+TexturePack* TinyDraw_Load_Pack(const char* fileName);
+
+/**
+ * Look up a region of a texture pack by name. Baked sprites are named after
+ * their file, e.g. `"paving 1.png"`.
+ *
+ * @param   TexturePack*    pack
+ * @param   char*           name
+ * @param   AtlasRegion*    region  written on success
+ *
+ * @return  int truthy if the region was found
+ */
+int TinyDraw_Find_Pack_Region(TexturePack* pack, const char* name, AtlasRegion* region);
+
+/**
+ * Release a texture pack & its textures.
+ *
+ * @param   TexturePack*    pack
+ */
+void TinyDraw_Unload_Pack(TexturePack* pack);
+
 /**
  * Prepare a sprite to be drawn.
  *
- * @param   float2  destPos
- * @param   float2  destSize
- * @param   float2  sourcePos   takes values between 0 and 1
- * @param   float2  sourceSize  takes values between 0 and 1
- * @param   Color   color
+ * Only writes to CPU memory. Staged sprites are uploaded in one go by
+ * `TinyDraw_Render`.
+ *
+ * @param   SDL_GPUTexture* texture
+ * @param   float2          destPos
+ * @param   float2          destSize
+ * @param   float2          sourcePos   takes values between 0 and 1
+ * @param   float2          sourceSize  takes values between 0 and 1
+ * @param   Color           color
  */
 void TinyDraw_Stage_Sprite(
+    SDL_GPUTexture* texture,
     float2 destPos,
     float2 destSize,
     float2 sourcePos,
@@ -169,608 +587,5788 @@ void TinyDraw_Stage_Sprite(
 );
 
 /**
- * Render staged sprites to the screen, or to a render target.
+ * Prepare a sprite to be drawn with its own pipeline and layer.
  *
- * @param   SDL_GPUGraphicsPipeline*    pipeline
+ * Layers are drawn in ascending order. Within a layer, sprites are grouped by
+ * pipeline & texture to minimize draw calls, so overlapping sprites that need
+ * a fixed order should be put on different layers.
+ *
+ * @param   SDL_GPUGraphicsPipeline*    pipeline    `NULL` to use the one passed to `TinyDraw_Render`
  * @param   SDL_GPUTexture*             texture
- * @param   float3                      camera
- * @param   SDL_GPUTexture*             renderTarget
- * @param   char                        clear
+ * @param   Uint16                      layer       takes values between 0 and 4095
+ * @param   float2                      destPos
+ * @param   float2                      destSize
+ * @param   float2                      sourcePos   takes values between 0 and 1
+ * @param   float2                      sourceSize  takes values between 0 and 1
+ * @param   Color                       color
  */
-void TinyDraw_Render(
+void TinyDraw_Stage_Sprite_Ex(
     SDL_GPUGraphicsPipeline* pipeline,
     SDL_GPUTexture* texture,
-    float3 camera,
-    SDL_GPUTexture* renderTarget,
-    char clear
+    Uint16 layer,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    Color color
 );
 
 /**
- * Clear the screen or a render target.
+ * Stage a sprite rotated by `rotation` radians around `origin`, given
+ * relative to `destPos`. Only vertex pipelines rotate sprites; instanced &
+ * storage pipelines drop rotated sprites with a log.
  *
- * @param   SDL_GPUTexture* renderTarget
+ * @param   SDL_GPUTexture* texture
+ * @param   float2          destPos
+ * @param   float2          destSize
+ * @param   float2          sourcePos
+ * @param   float2          sourceSize
+ * @param   float2          origin
+ * @param   float           rotation
+ * @param   Color           color
  */
-void TinyDraw_Clear(SDL_GPUTexture* renderTarget);
+void TinyDraw_Stage_Sprite_Rotated(
+    SDL_GPUTexture* texture,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    float2 origin,
+    float rotation,
+    Color color
+);
 
 /**
- * Destroy a pipeline after you're done with it.
+ * Stage many sprites sharing a texture in one call. Equivalent to calling
+ * `TinyDraw_Stage_Sprite` for each, but the batch grows & the texture is
+ * looked up once.
  *
- * @param   SDL_GPUGraphicsPipeline*    pipeline
+ * @param   SDL_GPUTexture*     texture
+ * @param   const SpriteDesc*   sprites
+ * @param   int                 count
  */
-void TinyDraw_Destroy_Pipeline(SDL_GPUGraphicsPipeline* pipeline);
+void TinyDraw_Stage_Sprites(
+    SDL_GPUTexture* texture,
+    const SpriteDesc* sprites,
+    int count
+);
 
 /**
- * Unload a shader after you're done with it.
+ * Create a staging context, so a worker thread can stage sprites without
+ * locking while other threads stage into their own. Every context's sprites
+ * are merged into the batch by the next `TinyDraw_Render` or
+ * `TinyDraw_Redraw`, after the sprites staged on the render thread, & sorted
+ * with them.
  *
- * @param   SDL_GPUShader* shader
+ * Create & destroy contexts on the render thread. A context must not be
+ * staged into while the render thread calls `TinyDraw_Render` or
+ * `TinyDraw_Redraw`, so join or wait for the workers first. Everything else
+ * in TinyDraw stays render-thread only.
+ *
+ * @return  StagingContext* `NULL` on failure
  */
-void TinyDraw_Unload_Shader(SDL_GPUShader* shader);
+StagingContext* TinyDraw_Create_StagingContext(void);
 
 /**
- * Unload a texture after you're done with it.
+ * `TinyDraw_Stage_Sprite_Ex` into a staging context. Safe to call from any
+ * one thread per context.
  *
- * @param   SDL_GPUTexture* texture
+ * @param   StagingContext*             context
+ * @param   SDL_GPUGraphicsPipeline*    pipeline    `NULL` to use the one passed to `TinyDraw_Render`
+ * @param   SDL_GPUTexture*             texture
+ * @param   Uint16                      layer       takes values between 0 and 4095
+ * @param   float2                      destPos
+ * @param   float2                      destSize
+ * @param   float2                      sourcePos   takes values between 0 and 1
+ * @param   float2                      sourceSize  takes values between 0 and 1
+ * @param   Color                       color
  */
-void TinyDraw_Unload_Texture(SDL_GPUTexture* texture);
+void TinyDraw_Stage_Sprite_To(
+    StagingContext* context,
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUTexture* texture,
+    Uint16 layer,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    Color color
+);
 
 /**
- * Quit TinyDraw.
+ * Sprites still staged in the context are dropped.
+ *
+ * @param   StagingContext* context
  */
-void TinyDraw_Quit(void);
-
-#ifdef TINYDRAW_IMPLEMENTATION
+void TinyDraw_Destroy_StagingContext(StagingContext* context);
 
-#define SDL_GPU_SHADERCROSS_IMPLEMENTATION
-#include <SDL_gpu_shadercross.h>
+/**
+ * Bake the sprites staged since the last `TinyDraw_Render` into a static
+ * layer, removing them from the batch. The layer keeps its own vertex buffer
+ * on the GPU, so drawing it again costs no staging & no upload.
+ *
+ * Textures & pipelines of the baked sprites must outlive the layer. Only
+ * sprites staged without a pipeline or with a vertex one can be baked: with
+ * an instanced or storage pipeline baking fails & the sprites stay staged.
+ *
+ * @return  StaticLayer*    `NULL` on failure or when nothing was staged
+ */
+StaticLayer* TinyDraw_Bake_StaticLayer(void);
 
-extern unsigned char* stbi_load(char const *filename, int *x, int *y, int *comp, int req_comp);
-extern void stbi_image_free(void *retval_from_stbi_load);
+/**
+ * Draw a static layer with the next `TinyDraw_Render`, beneath the sprites
+ * staged for it. Its draws without a pipeline of their own use the render's,
+ * which must then be a vertex pipeline, not an instanced or storage one.
+ *
+ * @param   StaticLayer*    layer
+ */
+void TinyDraw_Stage_StaticLayer(StaticLayer* layer);
 
-#define SPRITE_COUNT 1024
+/**
+ * @param   StaticLayer*    layer
+ */
+void TinyDraw_Destroy_StaticLayer(StaticLayer* layer);
 
-// File System
-static const char* basePath = NULL;
-// TODO: should this be larger?
-static char fullPath[256] = "";
+/**
+ * Create an empty tilemap. Tiles are numbered row by row through the
+ * tileset, starting at 0, & drawn `tileSize` pixels large with the map's
+ * top-left corner at the world origin.
+ *
+ * The map is split into chunks, each baked into its own static layer the
+ * first time it is drawn & rebuilt only after one of its tiles changes.
+ *
+ * @param   SDL_GPUTexture* tileset
+ * @param   int2            tilesetSize in pixels
+ * @param   int2            tileSize in pixels
+ * @param   int             width in tiles
+ * @param   int             height in tiles
+ *
+ * @return  Tilemap*        `NULL` on failure
+ */
+Tilemap* TinyDraw_Create_Tilemap(
+    SDL_GPUTexture* tileset,
+    int2 tilesetSize,
+    int2 tileSize,
+    int width,
+    int height
+);
 
-// Game metadata
-const char* title = "TinyDraw Test (" TINYDRAW_VERSION ")";
-const int2 sizeGame = {
-    .x = 160,
-    .y = 90,
-};
-const int2 sizeWindow = {
-    .x = 1280,
-    .y = 720,
-};
+/**
+ * @param   Tilemap*    tilemap
+ * @param   int         x
+ * @param   int         y
+ * @param   int         tile index into the tileset, up to 65534, or -1 for none
+ */
+void TinyDraw_Set_Tile(Tilemap* tilemap, int x, int y, int tile);
 
-// SDL_GPU spritebatch
-static SDL_GPUTransferBuffer* vertexBufferTransferBuffer = NULL;
-static SDL_GPUBuffer* indexBuffer = NULL;
-static SDL_GPUBuffer* vertexBuffer = NULL;
-static int spriteBatchCount = 0;
+/**
+ * @param   Tilemap*    tilemap
+ * @param   int         x
+ * @param   int         y
+ *
+ * @return  int         tile index, or -1 for none or outside the map
+ */
+int TinyDraw_Get_Tile(Tilemap* tilemap, int x, int y);
 
-// SDL_GPU misc
-static SDL_GPUDevice* device = NULL;
-static SDL_GPUSampler* sampler = NULL;
-static SDL_Window* window = NULL;
+/**
+ * Draw the chunks of a tilemap seen by `camera` with the next
+ * `TinyDraw_Render`, which should use the same camera & render target.
+ * Chunks outside the view are skipped, so the cost depends on the view & not
+ * the map size. Chunks are static layers, so that render must use a vertex
+ * pipeline, see `TinyDraw_Stage_StaticLayer`.
+ *
+ * @param   Tilemap*        tilemap
+ * @param   float3          camera
+ * @param   SDL_GPUTexture* renderTarget    sizes the view, `NULL` for the screen
+ */
+void TinyDraw_Stage_Tilemap(Tilemap* tilemap, float3 camera, SDL_GPUTexture* renderTarget);
 
-// SDL_GPU assets
-static SDL_GPUShader* vertexShader = NULL;
-static SDL_GPUShader* fragmentShader = NULL;
+/**
+ * @param   Tilemap*    tilemap
+ */
+void TinyDraw_Destroy_Tilemap(Tilemap* tilemap);
 
-// Static methods
+/**
+ * Begin recording a frame.
+ *
+ * Every `TinyDraw_Render` & `TinyDraw_Clear` until `TinyDraw_EndFrame` is
+ * recorded into a single command buffer, with one upload for all staged
+ * sprites & as few render passes as the order of the renders allows.
+ */
+void TinyDraw_BeginFrame(void);
+
+/**
+ * Upload, draw & submit everything recorded since `TinyDraw_BeginFrame`,
+ * then wait as set by `TinyDraw_Set_Frame_Pacing`. Input read after it
+ * returns is as fresh as the pacing allows.
+ *
+ * Renders are grouped into render passes: a render joins the last pass of
+ * its target unless a render since samples that target, or draws into a
+ * target it samples. Passes run in the order they were opened, so sampling
+ * a render target always sees what was rendered into it earlier in the
+ * frame. The swapchain is only acquired if something was drawn to the
+ * screen. Sprites staged after the frame's last `TinyDraw_Render` are
+ * discarded.
+ */
+void TinyDraw_EndFrame(void);
+
+/**
+ * Pace frames from `TinyDraw_EndFrame`. It waits until the GPU has at most
+ * `framesInFlight` - 1 frames left to finish, so 1 trades throughput for the
+ * lowest latency. Then it sleeps out the rest of the frame, measured from
+ * the previous deadline, so the loop keeps its rate whatever a frame took.
+ * After a hitch the next frame starts right away instead of rushing to
+ * catch up.
+ *
+ * By default frames aren't waited for & up to
+ * `TINYDRAW_FRAMES_IN_FLIGHT_MAX` are in flight.
+ *
+ * @param   int fps             frames per second, 0 to not wait
+ * @param   int framesInFlight  1 to `TINYDRAW_FRAMES_IN_FLIGHT_MAX`
+ */
+void TinyDraw_Set_Frame_Pacing(int fps, int framesInFlight);
+
+/**
+ * Choose how the swapchain presents: `SDL_GPU_PRESENTMODE_VSYNC`, the
+ * default, `SDL_GPU_PRESENTMODE_MAILBOX`, which replaces a queued frame
+ * instead of waiting behind it, or `SDL_GPU_PRESENTMODE_IMMEDIATE`, which
+ * may tear.
+ *
+ * @param   SDL_GPUPresentMode  mode
+ *
+ * @return  int truthy for success, falsy if the window doesn't support it
+ */
+int TinyDraw_Set_Present_Mode(SDL_GPUPresentMode mode);
+
+/**
+ * Render staged sprites to the screen, or to a render target.
+ *
+ * Staged sprites are sorted by layer, pipeline & texture, and consecutive
+ * sprites sharing all three are merged into a single draw call. With
+ * `TinyDraw_Set_Depth`, sprites of opaque pipelines are drawn first, front
+ * to back.
+ *
+ * Inside `TinyDraw_BeginFrame`/`TinyDraw_EndFrame` this only records the
+ * sprites; outside of a frame it is a frame of its own. Clearing discards
+ * anything already recorded for the same target this frame.
+ *
+ * The camera's `x` & `y` are the top left corner of the view, & `z` its
+ * zoom: the view covers the target's virtual resolution divided by `z`. A
+ * `z` of 0 or less counts as 1.
+ *
+ * @param   SDL_GPUGraphicsPipeline*    pipeline        used by sprites staged without one
+ * @param   float3                      camera          top left & zoom
+ * @param   SDL_GPUTexture*             renderTarget
+ * @param   char                        clear
+ */
+void TinyDraw_Render(
+    SDL_GPUGraphicsPipeline* pipeline,
+    float3 camera,
+    SDL_GPUTexture* renderTarget,
+    char clear
+);
+
+/**
+ * Draw the sprites of the previous `TinyDraw_Render` again, with another
+ * camera and/or render target, without staging or uploading them again.
+ * Sprites staged since that render are drawn on top.
+ *
+ * Only works inside `TinyDraw_BeginFrame`/`TinyDraw_EndFrame`.
+ *
+ * @param   float3          camera
+ * @param   SDL_GPUTexture* renderTarget
+ */
+void TinyDraw_Redraw(float3 camera, SDL_GPUTexture* renderTarget);
+
+/**
+ * Read back what a render target holds at the end of this frame, without
+ * waiting for the GPU. The copy is downloaded by the frame's own command
+ * buffer into one of `TINYDRAW_READBACK_MAX` transfer buffers, & `callback`
+ * is called by the `TinyDraw_EndFrame` that first sees the frame finished,
+ * usually a frame or two later, or by `TinyDraw_Quit`.
+ *
+ * Only works inside `TinyDraw_BeginFrame`/`TinyDraw_EndFrame`, & not for
+ * transient targets or the screen. Unloading the render target before the
+ * frame ends cancels the read, & `callback` is never called.
+ *
+ * @param   SDL_GPUTexture*     renderTarget    from `TinyDraw_Create_RenderTarget`
+ * @param   ReadbackCallback    callback
+ * @param   void*               userdata        passed to `callback`
+ *
+ * @return  int truthy if queued, falsy if every transfer buffer is still
+ *              waiting on the GPU, so the frame is skipped instead of stalled
+ */
+int TinyDraw_Read_RenderTarget(
+    SDL_GPUTexture* renderTarget,
+    ReadbackCallback callback,
+    void* userdata
+);
+
+/**
+ * Build a full mip chain for every PNG loaded from now on, with a box
+ * filter on the CPU. Off by default. Sprites drawn smaller than their
+ * texture then sample a smaller level instead of aliasing.
+ *
+ * @param   char    enabled
+ */
+void TinyDraw_Set_Mipmaps(char enabled);
+
+/**
+ * Get one of the shared samplers, created on first use. Sampling between
+ * mip levels follows `filter`.
+ *
+ * Only vertex pipelines tile with `TINYDRAW_ADDRESS_REPEAT` &
+ * `TINYDRAW_ADDRESS_MIRROR`. Instanced & storage pipelines store source
+ * rects as unorm16, which keeps texel precision on large atlases, so their
+ * UVs are clamped to 0..1 & the texture is never repeated.
+ *
+ * @param   int filter      `TINYDRAW_FILTER_NEAREST` or `TINYDRAW_FILTER_LINEAR`
+ * @param   int addressMode `TINYDRAW_ADDRESS_CLAMP`, `TINYDRAW_ADDRESS_REPEAT`
+ *                          or `TINYDRAW_ADDRESS_MIRROR`
+ *
+ * @return  SDL_GPUSampler* `NULL` on failure
+ */
+SDL_GPUSampler* TinyDraw_Get_Sampler(int filter, int addressMode);
+
+/**
+ * Sample a texture with another sampler than the default nearest, clamped
+ * one, in every draw that uses it. Source rects outside 0..1 only tile on
+ * vertex pipelines, see `TinyDraw_Get_Sampler`.
+ *
+ * @param   SDL_GPUTexture* texture
+ * @param   int             filter
+ * @param   int             addressMode
+ */
+void TinyDraw_Set_Texture_Sampler(SDL_GPUTexture* texture, int filter, int addressMode);
+
+/**
+ * Skip sprites that lie entirely outside the camera of their render, before
+ * they are uploaded. Off by default, since a custom vertex shader may move
+ * sprites into view; static layers & tilemaps are never culled here. How many
+ * were culled is in `TinyDraw_Get_Frame_Stats`.
+ *
+ * @param   char    enabled
+ * @param   float   margin  in world units, added around the view
+ */
+void TinyDraw_Set_Culling(char enabled, float margin);
+
+/**
+ * Counters & timings of the last frame, from the end of the frame before it
+ * to its `TinyDraw_EndFrame`, so loads & uploads between frames count
+ * towards the next one.
+ *
+ * @return  FrameStats
+ */
+FrameStats TinyDraw_Get_Frame_Stats(void);
+
+/**
+ * Clear the screen or a render target.
+ *
+ * Inside a frame this costs nothing: the clear is folded into the load
+ * operation of the target's render pass.
+ *
+ * @param   SDL_GPUTexture* renderTarget
+ */
+void TinyDraw_Clear(SDL_GPUTexture* renderTarget);
+
+/**
+ * Destroy a pipeline after you're done with it. Shared pipelines are released
+ * by the last destroy.
+ *
+ * @param   SDL_GPUGraphicsPipeline*    pipeline
+ */
+void TinyDraw_Destroy_Pipeline(SDL_GPUGraphicsPipeline* pipeline);
+
+/**
+ * Unload a shader after you're done with it.
+ *
+ * @param   SDL_GPUShader* shader
+ */
+void TinyDraw_Unload_Shader(SDL_GPUShader* shader);
+
+/**
+ * Unload a texture after you're done with it.
+ *
+ * @param   SDL_GPUTexture* texture
+ */
+void TinyDraw_Unload_Texture(SDL_GPUTexture* texture);
+
+/**
+ * Quit TinyDraw.
+ */
+void TinyDraw_Quit(void);
+
+#ifdef TINYDRAW_IMPLEMENTATION
+
+#define SDL_GPU_SHADERCROSS_IMPLEMENTATION
+#include <SDL_gpu_shadercross.h>
+
+extern unsigned char* stbi_load(char const *filename, int *x, int *y, int *comp, int req_comp);
+extern void stbi_image_free(void *retval_from_stbi_load);
+
+// Initial sprite batch capacity, doubled whenever more sprites are staged
+#define SPRITE_COUNT 1024
+// Most sprites a single draw can address with 16-bit indices
+#define SPRITE_COUNT_16BIT (65536 / 4)
+// Limited by the staging index stored in the low bits of the sort key
+#define SPRITE_COUNT_MAX (1 << SPRITE_KEY_SPRITE_BITS)
+
+// Sprite sort key, most significant bits first: view (8), blended (1),
+// layer (12), pipeline (7), texture (12) & staging index (24). A view is one
+// `TinyDraw_Render` call, i.e. a render target & camera. The staging index
+// keeps the sort stable and points back at the sprite's staged vertices.
+// With depth on, every sprite but those of opaque pipelines is flagged
+// blended before sorting, & opaque ones store their layer inverted, so they
+// come first & front to back.
+#define SPRITE_KEY_SPRITE_BITS 24
+#define SPRITE_KEY_TEXTURE_SHIFT 24
+#define SPRITE_KEY_PIPELINE_SHIFT 36
+#define SPRITE_KEY_LAYER_SHIFT 43
+#define SPRITE_KEY_BLENDED_SHIFT 55
+#define SPRITE_KEY_VIEW_SHIFT 56
+#define SPRITE_KEY_FIELD(key, shift, bits) ((int) (((key) >> (shift)) & ((1ull << (bits)) - 1)))
+#define SPRITE_TEXTURE_MAX (1 << 12)
+#define SPRITE_PIPELINE_MAX (1 << 7)
+#define SPRITE_LAYER_MAX ((1 << 12) - 1)
+#define SPRITE_VIEW_MAX (1 << 8)
+#define SPRITE_STATIC_MAX 4096
+
+// Tilemaps
+#define TILEMAP_CHUNK_SIZE 32
+
+// Background texture loads
+#define TEXTURE_LOAD_THREADS_MAX 4
+// Bytes of decoded textures uploaded by one `TinyDraw_BeginFrame`, at least
+// one texture is always uploaded
+#define TEXTURE_LOAD_FRAME_BUDGET (16 * 1024 * 1024)
+// Decoded but not uploaded yet, `TINYDRAW_LOAD_PENDING` to the caller
+#define TEXTURE_LOAD_DECODED 2
+
+// Atlases
+#define ATLAS_PAGE_MAX 16
+
+// Textures with their own sampler
+#define SAMPLER_OVERRIDE_MAX 1024
+// Most render targets alive at once
+#define RENDER_TARGET_MAX 256
+
+// Render targets handed out by `TinyDraw_Get_Transient_Target` in a frame
+#define TRANSIENT_TARGET_MAX 64
+
+// Depth buffers, one per size of render target
+#define DEPTH_TARGET_MAX 16
+#define DEPTH_FORMAT SDL_GPU_TEXTUREFORMAT_D16_UNORM
+
+// File System
+static const char* basePath = NULL;
+// TODO: should this be larger?
+static char fullPath[256] = "";
+// Writable, for shaders translated from SPIR-V, see `Shader_Load_Cached`
+static char* cachePath = NULL;
+
+// Part of every cached shader's key, bump it whenever SDL_shadercross or the
+// compilers it drives change, so their old translations are never loaded
+#define SHADER_CACHE_VERSION 1
+// FNV-1a offset basis, see `Shader_Hash`
+#define SHADER_HASH_SEED 0xCBF29CE484222325ull
+
+// Ahead of every cached shader, to tell a complete translation from a
+// truncated or corrupt file
+typedef struct Shader_Cache_Header
+{
+    Uint64 version;
+    Uint64 size;
+    // Of the translation that follows
+    Uint64 hash;
+} Shader_Cache_Header;
+
+// Game metadata
+const char* title = "TinyDraw Test (" TINYDRAW_VERSION ")";
+// Virtual resolution of the screen, see `TinyDraw_Set_Resolution`
+int2 sizeGame = {
+    .x = 160,
+    .y = 90,
+};
+static char sizeIntegerScale = 1;
+int2 sizeWindow = {
+    .x = 1280,
+    .y = 720,
+};
+
+// Pipelines
+#define PIPELINE_MODE_VERTEX 0
+#define PIPELINE_MODE_INSTANCED 1
+#define PIPELINE_MODE_STORAGE 2
+
+// Every pipeline created, & what it was created from. Creating one from the
+// same shaders & state again hands back the existing pipeline, which is only
+// released once each creation was destroyed.
+typedef struct Pipeline_Info
+{
+    SDL_GPUGraphicsPipeline* pipeline;
+    // `NULL` once unloaded, so a new shader at the same address can't match
+    SDL_GPUShader* vertexShader;
+    SDL_GPUShader* fragmentShader;
+    int mode;
+    char opaque;
+    char depth;
+    SDL_GPUTextureFormat format;
+    int references;
+} Pipeline_Info;
+
+static Pipeline_Info pipelineInfos[SPRITE_PIPELINE_MAX];
+static int pipelineInfoCount = 0;
+
+// A GPU buffer streamed from the CPU every frame. Its transfer buffer is
+// created once per size & mapped with `cycle` on every flush, so SDL hands
+// back a fresh backing while older frames are still in flight.
+typedef struct SpriteBatch_Buffer
+{
+    SDL_GPUBuffer* buffer;
+    SDL_GPUTransferBuffer* transferBuffer;
+    Uint32 size;
+    SDL_GPUBufferUsageFlags usage;
+    const char* name;
+} SpriteBatch_Buffer;
+
+// SDL_GPU spritebatch
+static SpriteBatch_Buffer vertexStream = {
+    .usage = SDL_GPU_BUFFERUSAGE_VERTEX_BIT,
+    .name = "TinyDraw Vertex Buffer",
+};
+static SpriteBatch_Buffer instanceStream = {
+    .usage = SDL_GPU_BUFFERUSAGE_VERTEX_BIT,
+    .name = "TinyDraw Instance Buffer",
+};
+static SpriteBatch_Buffer storageStream = {
+    .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ_BIT,
+    .name = "TinyDraw Sprite Storage Buffer",
+};
+static SDL_GPUBuffer* indexBuffer = NULL;
+// Only created once a single draw needs more than `SPRITE_COUNT_16BIT`
+static SDL_GPUBuffer* indexBuffer32 = NULL;
+static int indexBuffer32Capacity = 0;
+
+// Sprites as staged, turned into vertices or instances at flush. The
+// destination rects live in an array of their own, so culling reads 16
+// bytes a sprite, while staging & packing still move whole records.
+typedef struct SpriteBatch_Dest
+{
+    float2 destPos;
+    float2 destSize;
+} SpriteBatch_Dest;
+
+typedef struct SpriteBatch_Source
+{
+    float2 sourcePos;
+    float2 sourceSize;
+    Color color;
+} SpriteBatch_Source;
+
+typedef struct SpriteBatch_Rotation
+{
+    float angle;
+    // Relative to `destPos`
+    float2 origin;
+} SpriteBatch_Rotation;
+
+typedef struct SpriteBatch_Store
+{
+    SpriteBatch_Dest* dest;
+    SpriteBatch_Source* source;
+    // `NULL` until the first rotated sprite is staged
+    SpriteBatch_Rotation* rotation;
+} SpriteBatch_Store;
+
+static SpriteBatch_Store spriteBatch = { 0 };
+static Uint64* spriteBatchKeys = NULL;
+static int spriteBatchCapacity = 0;
+static int spriteBatchCount = 0;
+
+// Textures & pipelines referenced by the current batch, indexed by the slots
+// packed into the sort key. Pipeline slot 0 is the one passed to
+// `TinyDraw_Render`.
+static void* batchTextures[SPRITE_TEXTURE_MAX];
+static int batchTextureCount = 0;
+static void* batchPipelines[SPRITE_PIPELINE_MAX] = { NULL };
+static int batchPipelineCount = 1;
+
+// Runs of sorted sprites sharing a layer, pipeline & texture
+typedef struct SpriteBatch_Draw
+{
+    Uint64 key;
+    int first;
+    int count;
+    int mode;
+    // First sprite in the GPU buffer for `mode`
+    int offset;
+} SpriteBatch_Draw;
+
+static SpriteBatch_Draw* batchDraws = NULL;
+static int batchDrawCapacity = 0;
+static int batchDrawCount = 0;
+// Sprites packed into each stream by the last sort
+static int batchVertexSpriteCount = 0;
+static int batchInstanceCount = 0;
+static int batchStorageCount = 0;
+
+// One run of a static layer, drawn with the 16-bit index buffer
+typedef struct StaticLayer_Draw
+{
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUTexture* texture;
+    int first;
+    int count;
+} StaticLayer_Draw;
+
+struct StaticLayer
+{
+    SDL_GPUBuffer* buffer;
+    StaticLayer_Draw* draws;
+    int drawCount;
+};
+
+typedef struct Tilemap_Chunk
+{
+    // Created the first time the chunk is drawn, `NULL` while empty
+    StaticLayer* layer;
+    char dirty;
+} Tilemap_Chunk;
+
+struct Tilemap
+{
+    SDL_GPUTexture* tileset;
+    int2 tilesetSize;
+    int2 tileSize;
+    int width;
+    int height;
+    // Tile index + 1, so 0 is empty
+    Uint16* tiles;
+    int2 chunkCount;
+    Tilemap_Chunk* chunks;
+};
+
+// Sprites staged by one worker thread. Keys have the layout of
+// `spriteBatchKeys`, without a view & with slots into the context's own
+// texture & pipeline tables, remapped when merged.
+struct StagingContext
+{
+    SpriteBatch_Store store;
+    Uint64* keys;
+    int capacity;
+    int count;
+    void* textures[SPRITE_TEXTURE_MAX];
+    int textureCount;
+    void* pipelines[SPRITE_PIPELINE_MAX];
+    int pipelineCount;
+    StagingContext* next;
+};
+
+// Every live staging context, merged by `SpriteBatch_Record_View`
+static StagingContext* stagingContexts = NULL;
+
+struct TextureLoad
+{
+    char path[256];
+    // Decoded RGBA mip chain, freed once uploaded
+    Uint8* pixels;
+    int width;
+    int height;
+    Uint32 levelCount;
+    Uint32 size;
+    SDL_GPUTexture* texture;
+    int state;
+    // In the queue or the decoded list
+    TextureLoad* next;
+};
+
+struct TexturePack
+{
+    SDL_GPUTexture** textures;
+    int textureCount;
+    PackRegion* regions;
+    int regionCount;
+};
+
+// One segment of the skyline, the top edge of everything packed into an
+// atlas page so far
+typedef struct Atlas_Node
+{
+    int x;
+    int y;
+    int width;
+} Atlas_Node;
+
+typedef struct Atlas_Page
+{
+    SDL_GPUTexture* texture;
+    // Kept on the CPU, so rows can be uploaded again after more images are
+    // packed
+    Uint8* pixels;
+    // Sorted by `x` & spanning the whole page
+    Atlas_Node* skyline;
+    int nodeCount;
+    // Rows written since the last upload, empty when `dirtyTop` isn't
+    // above `dirtyBottom`
+    int dirtyTop;
+    int dirtyBottom;
+} Atlas_Page;
+
+struct Atlas
+{
+    int pageSize;
+    int padding;
+    Atlas_Page pages[ATLAS_PAGE_MAX];
+    int pageCount;
+};
+
+// Workers pop loads from the queue & push them onto the decoded list, which
+// `TinyDraw_BeginFrame` uploads. `textureLoadMutex` guards both lists & the
+// state of every load.
+static SDL_Thread* textureLoadThreads[TEXTURE_LOAD_THREADS_MAX];
+static int textureLoadThreadCount = 0;
+static SDL_Mutex* textureLoadMutex = NULL;
+static SDL_Condition* textureLoadQueued = NULL;
+static SDL_Condition* textureLoadDecoded = NULL;
+static TextureLoad* textureLoadQueue = NULL;
+static TextureLoad* textureLoadQueueTail = NULL;
+static TextureLoad* textureLoadDecodedList = NULL;
+static TextureLoad* textureLoadDecodedTail = NULL;
+static char textureLoadQuit = 0;
+
+// Static layers staged this frame, in the order of their views
+static StaticLayer* batchStaticLayers[SPRITE_STATIC_MAX];
+static int batchStaticCount = 0;
+// Static layers staged before the last recorded view
+static int batchViewStaticCount = 0;
+
+// Recorded by `TinyDraw_Render`, drawn by `TinyDraw_EndFrame`
+typedef struct SpriteBatch_View
+{
+    SDL_GPUGraphicsPipeline* pipeline;
+    float3 position;
+    matrix4x4 camera;
+    // World units covered, the target's virtual resolution over the zoom
+    float2 size;
+    int target;
+    char clear;
+    // Render pass drawing it, see `SpriteBatch_Build_Passes`
+    int pass;
+    // Set when a later clear in the same render pass discards this view
+    char skip;
+    int firstDraw;
+    int drawCount;
+    int firstStatic;
+    int staticCount;
+    // View whose draws are replayed before this one's, or -1
+    int source;
+    // Set when a later view replays this one, so its sprites can't be culled
+    // against its own camera
+    char replayed;
+} SpriteBatch_View;
+
+static SpriteBatch_View batchViews[SPRITE_VIEW_MAX];
+static int batchViewCount = 0;
+// Last view recorded by `TinyDraw_Render`, replayed by `TinyDraw_Redraw`
+static int batchLastRender = -1;
+// Sprites staged before the last recorded view
+static int batchViewSpriteCount = 0;
+// Culling of staged sprites against their view, see `TinyDraw_Set_Culling`
+static char cullEnabled = 0;
+static float cullMargin = 0;
+static Uint8* cullKeep = NULL;
+static int cullKeepCapacity = 0;
+// Render targets in the order they were first used this frame, `NULL` being
+// the screen
+static void* batchTargets[SPRITE_VIEW_MAX];
+static int batchTargetCount = 0;
+
+// One render pass of a frame: views drawn into one target, one after the
+// other
+typedef struct SpriteBatch_Pass
+{
+    int target;
+    SDL_GPULoadOp loadOp;
+    SDL_GPUStoreOp storeOp;
+    // Targets sampled by its views, one bit per index into `batchTargets`
+    Uint64 reads[SPRITE_VIEW_MAX / 64];
+} SpriteBatch_Pass;
+
+static SpriteBatch_Pass batchPasses[SPRITE_VIEW_MAX];
+static int batchPassCount = 0;
+
+// Frame
+static SDL_GPUCommandBuffer* frameCommandBuffer = NULL;
+// Counted since the last `TinyDraw_EndFrame`, & what it counted
+static FrameStats frameStats = { 0 };
+static FrameStats frameStatsLast = { 0 };
+
+// CPU timers behind the timings of `FrameStats`, compiled out unless
+// `TINYDRAW_PROFILE` is defined
+typedef struct Profile_Ticks
+{
+    Uint64 stage;
+    Uint64 render;
+    Uint64 flush;
+    Uint64 submit;
+} Profile_Ticks;
+
+static Profile_Ticks profileTicks = { 0 };
+
+// A submitted frame, see `TinyDraw_Set_Frame_Pacing`
+typedef struct Frame_Fence
+{
+    SDL_GPUFence* fence;
+    // When the frame started, in nanoseconds
+    Uint64 start;
+} Frame_Fence;
+
+// Oldest first
+static Frame_Fence frameFences[TINYDRAW_FRAMES_IN_FLIGHT_MAX];
+static int frameFenceCount = 0;
+static int frameFenceLimit = TINYDRAW_FRAMES_IN_FLIGHT_MAX;
+// Sleeping overshoots, so `Frame_Pace` spins the end of the frame, in
+// nanoseconds, pausing the core in between checks where it can
+#define FRAME_SPIN 200000
+#ifdef SDL_SSE2_INTRINSICS
+#define FRAME_SPIN_PAUSE() _mm_pause()
+#else
+#define FRAME_SPIN_PAUSE()
+#endif
+// In nanoseconds, 0 doesn't wait
+static Uint64 framePeriod = 0;
+static Uint64 frameDeadline = 0;
+static Uint64 frameStart = 0;
+// In milliseconds, of the latest frame known finished
+static double frameLatency = 0;
+// Frames with a fence, counted as they're submitted & as they finish
+static Uint64 frameSubmittedCount = 0;
+static Uint64 frameFinishedCount = 0;
+
+// Readbacks, see `TinyDraw_Read_RenderTarget`
+#define READBACK_FREE 0
+#define READBACK_REQUESTED 1
+#define READBACK_RECORDED 2
+#define READBACK_SUBMITTED 3
+
+// A transfer buffer of the ring, kept at its largest size for reuse
+typedef struct Readback_Slot
+{
+    SDL_GPUTransferBuffer* transferBuffer;
+    Uint32 capacity;
+    int state;
+    SDL_GPUTexture* texture;
+    int2 size;
+    // `frameSubmittedCount` of the frame copying it
+    Uint64 frame;
+    ReadbackCallback callback;
+    void* userdata;
+} Readback_Slot;
+
+static Readback_Slot readbackSlots[TINYDRAW_READBACK_MAX];
+
+#ifdef TINYDRAW_PROFILE
+#define PROFILE_START(timer) const Uint64 timer = SDL_GetPerformanceCounter()
+#define PROFILE_STOP(timer, total) ((total) += SDL_GetPerformanceCounter() - (timer))
+#else
+#define PROFILE_START(timer)
+#define PROFILE_STOP(timer, total)
+#endif
+
+// SDL_GPU misc
+static SDL_GPUDevice* device = NULL;
+static SDL_GPUSampler* sampler = NULL;
+static SDL_Window* window = NULL;
+
+// Samplers by filter & address mode, created on first use. `sampler` is the
+// nearest, clamped one.
+static SDL_GPUSampler* samplerCache[2][3];
+
+typedef struct Sampler_Override
+{
+    SDL_GPUTexture* texture;
+    SDL_GPUSampler* sampler;
+} Sampler_Override;
+
+typedef struct RenderTarget_Info
+{
+    SDL_GPUTexture* texture;
+    int2 size;
+} RenderTarget_Info;
+
+// Sizes of the render targets, the virtual resolution of their cameras
+static RenderTarget_Info renderTargets[RENDER_TARGET_MAX];
+static int renderTargetCount = 0;
+
+// Depth buffers are cleared at the start of every pass & never stored, so
+// passes of the same size share one
+typedef struct Depth_Target
+{
+    SDL_GPUTexture* texture;
+    Uint32 width;
+    Uint32 height;
+} Depth_Target;
+
+static char depthEnabled = 0;
+static Depth_Target depthTargets[DEPTH_TARGET_MAX];
+static int depthTargetCount = 0;
+
+// The address of one stands in for a texture until `TinyDraw_EndFrame`
+// gives it one from `transientPool`
+typedef struct Transient_Target
+{
+    int2 size;
+    SDL_GPUTexture* texture;
+    // First & last render pass using it
+    int firstPass;
+    int lastPass;
+} Transient_Target;
+
+// Textures lent to transient targets, kept from frame to frame
+typedef struct Transient_Texture
+{
+    SDL_GPUTexture* texture;
+    int2 size;
+    // Last render pass of this frame using it
+    int busyUntil;
+} Transient_Texture;
+
+static Transient_Target transientTargets[TRANSIENT_TARGET_MAX];
+static int transientTargetCount = 0;
+static Transient_Texture* transientPool = NULL;
+static int transientPoolCount = 0;
+
+// Textures sampled with something else than `sampler`
+static Sampler_Override samplerOverrides[SAMPLER_OVERRIDE_MAX];
+static int samplerOverrideCount = 0;
+// Build mip chains for the textures loaded from now on
+static char samplerMipmaps = 0;
+
+// SDL_GPU assets
+static SDL_GPUShader* vertexShader = NULL;
+static SDL_GPUShader* fragmentShader = NULL;
+
+// Static methods
+
+static matrix4x4 Matrix4x4_CreateOrthographicOffCenter(
+    float left,
+    float right,
+    float bottom,
+    float top,
+    float zNearPlane,
+    float zFarPlane
+) {
+    return (matrix4x4){
+        2.0f / (right - left), 0, 0, 0,
+        0, 2.0f / (top - bottom), 0, 0,
+        0, 0, 1.0f / (zNearPlane - zFarPlane), 0,
+        (left + right) / (left - right), (top + bottom) / (bottom - top), zNearPlane / (zNearPlane - zFarPlane), 1
+    };
+}
+
+/**
+ * Format of render targets & of what pipelines draw to: the swapchain's, or
+ * plain RGBA without a window.
+ */
+static SDL_GPUTextureFormat RenderTarget_Format(void)
+{
+    return window != NULL
+        ? SDL_GetGPUSwapchainTextureFormat(device, window)
+        : SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+}
+
+static SDL_GPUTexture* RenderTarget_Create_Texture(int width, int height)
+{
+    return SDL_CreateGPUTexture(device,
+        &(SDL_GPUTextureCreateInfo){
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = RenderTarget_Format(),
+            .width = width,
+            .height = height,
+            .layerCountOrDepth = 1,
+            .levelCount = 1,
+            .usageFlags = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET_BIT | SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT,
+        }
+    );
+}
+
+/**
+ * Virtual resolution of a render target, or of the screen for `NULL`.
+ */
+static int2 RenderTarget_Size(SDL_GPUTexture* renderTarget)
+{
+    for (int i = 0; i < renderTargetCount; i++) {
+        if (renderTargets[i].texture == renderTarget) {
+            return renderTargets[i].size;
+        }
+    }
+    for (int i = 0; i < transientTargetCount; i++) {
+        if ((SDL_GPUTexture*) &transientTargets[i] == renderTarget) {
+            return transientTargets[i].size;
+        }
+    }
+    
+    return sizeGame;
+}
+
+static Transient_Target* Transient_Find(const void* texture)
+{
+    for (int i = 0; i < transientTargetCount; i++) {
+        if ((const void*) &transientTargets[i] == texture) {
+            return &transientTargets[i];
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * World units a camera sees on a target of virtual resolution `size`.
+ */
+static float2 Camera_Size(float3 camera, int2 size)
+{
+    const float zoom = camera.z > 0 ? camera.z : 1;
+    return (float2){ .x = size.x / zoom, .y = size.y / zoom };
+}
+
+static matrix4x4 Camera_Matrix(float3 camera, float2 size)
+{
+    return Matrix4x4_CreateOrthographicOffCenter(
+        camera.x,
+        camera.x + size.x,
+        camera.y + size.y,
+        camera.y,
+        0,
+        -1
+    );
+}
+
+/**
+ * Where the screen's virtual resolution lands in a swapchain texture of
+ * `width` x `height` pixels: scaled up as far as it fits & centered, leaving
+ * black bars around it.
+ */
+static SDL_GPUViewport Screen_Viewport(Uint32 width, Uint32 height)
+{
+    float scale = SDL_min((float) width / sizeGame.x, (float) height / sizeGame.y);
+    if (sizeIntegerScale) {
+        // Smaller than the virtual resolution is still drawn at 1:1, cropped
+        scale = SDL_max(SDL_floorf(scale), 1);
+    }
+    
+    const float viewportWidth = sizeGame.x * scale;
+    const float viewportHeight = sizeGame.y * scale;
+    return (SDL_GPUViewport){
+        .x = SDL_floorf((width - viewportWidth) / 2),
+        .y = SDL_floorf((height - viewportHeight) / 2),
+        .w = viewportWidth,
+        .h = viewportHeight,
+        .minDepth = 0,
+        .maxDepth = 1,
+    };
+}
+
+/**
+ * Depth of the sprites on `layer`, between the near & far planes of
+ * `Camera_Matrix` & in front of the cleared depth of 1. Higher layers are
+ * nearer.
+ */
+static float Sprite_Depth(int layer)
+{
+    return 1.0f - (layer + 1.0f) / (SPRITE_LAYER_MAX + 2.0f);
+}
+
+/**
+ * Layer of a sorted sprite key, undoing `SpriteBatch_Order_Opaque`.
+ */
+static int SpriteBatch_Key_Layer(Uint64 key)
+{
+    const int layer = SPRITE_KEY_FIELD(key, SPRITE_KEY_LAYER_SHIFT, 12);
+    if (depthEnabled && SPRITE_KEY_FIELD(key, SPRITE_KEY_BLENDED_SHIFT, 1) == 0) {
+        return SPRITE_LAYER_MAX - layer;
+    }
+    
+    return layer;
+}
+
+/**
+ * A depth buffer of `width` x `height`, created the first time that size is
+ * asked for.
+ */
+static SDL_GPUTexture* Depth_Target_For_Size(Uint32 width, Uint32 height)
+{
+    for (int i = 0; i < depthTargetCount; i++) {
+        if (depthTargets[i].width == width && depthTargets[i].height == height) {
+            return depthTargets[i].texture;
+        }
+    }
+    
+    if (depthTargetCount == DEPTH_TARGET_MAX) {
+        // SDL keeps it alive until the passes already using it are done
+        SDL_ReleaseGPUTexture(device, depthTargets[--depthTargetCount].texture);
+    }
+    
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture(device,
+        &(SDL_GPUTextureCreateInfo){
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = DEPTH_FORMAT,
+            .width = width,
+            .height = height,
+            .layerCountOrDepth = 1,
+            .levelCount = 1,
+            .usageFlags = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET_BIT,
+        }
+    );
+    if (texture == NULL) {
+        SDL_Log("Failed to create %ux%u depth buffer", width, height);
+        return NULL;
+    }
+    
+    depthTargets[depthTargetCount++] = (Depth_Target){
+        .texture = texture,
+        .width = width,
+        .height = height,
+    };
+    
+    return texture;
+}
+
+static SDL_GPUBuffer* SpriteBatch_Create_IndexBuffer(
+    SDL_GPUCopyPass* copyPass,
+    int spriteCount,
+    SDL_GPUIndexElementSize elementSize
+) {
+    static const Uint32 quad[6] = { 0, 1, 2, 0, 2, 3 };
+    const Uint32 indexSize = elementSize == SDL_GPU_INDEXELEMENTSIZE_32BIT
+        ? sizeof(Uint32)
+        : sizeof(Uint16);
+    const Uint32 sizeInBytes = indexSize * 6 * spriteCount;
+    
+    SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer(
+        device,
+        &(SDL_GPUBufferCreateInfo) {
+            .usageFlags = SDL_GPU_BUFFERUSAGE_INDEX_BIT,
+            .sizeInBytes = sizeInBytes
+        }
+    );
+    if (buffer == NULL) {
+        SDL_Log("Failed to create index buffer");
+        return NULL;
+    }
+    SDL_SetGPUBufferName(
+        device,
+        buffer,
+        "TinyDraw Index Buffer"
+    );
+    
+    SDL_GPUTransferBuffer* bufferTransferBuffer = SDL_CreateGPUTransferBuffer(
+        device,
+        &(SDL_GPUTransferBufferCreateInfo) {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .sizeInBytes = sizeInBytes
+        }
+    );
+    void* indexData = SDL_MapGPUTransferBuffer(
+        device,
+        bufferTransferBuffer,
+        SDL_FALSE
+    );
+    for (int i = 0; i < spriteCount; i++) {
+        for (int j = 0; j < 6; j++) {
+            const Uint32 index = i * 4 + quad[j];
+            if (indexSize == sizeof(Uint32)) {
+                ((Uint32*) indexData)[i * 6 + j] = index;
+            } else {
+                ((Uint16*) indexData)[i * 6 + j] = (Uint16) index;
+            }
+        }
+    }
+    SDL_UnmapGPUTransferBuffer(device, bufferTransferBuffer);
+    SDL_UploadToGPUBuffer(
+        copyPass,
+        &(SDL_GPUTransferBufferLocation) {
+            .transferBuffer = bufferTransferBuffer,
+            .offset = 0
+        },
+        &(SDL_GPUBufferRegion) {
+            .buffer = buffer,
+            .offset = 0,
+            .size = sizeInBytes
+        },
+        SDL_FALSE
+    );
+    SDL_ReleaseGPUTransferBuffer(device, bufferTransferBuffer);
+    frameStats.uploadBytes += sizeInBytes;
+    
+    return buffer;
+}
+
+/**
+ * Grow a streamed buffer & its transfer buffer geometrically until they hold
+ * `size` bytes. Buffers still in flight are released lazily by SDL, so this
+ * is safe mid-frame.
+ */
+static int SpriteBatch_Reserve_Buffer(SpriteBatch_Buffer* stream, Uint32 size)
+{
+    if (size <= stream->size) {
+        return 1;
+    }
+    
+    Uint64 capacity = stream->size ? stream->size : 4096;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    if (capacity > SDL_MAX_UINT32) {
+        capacity = SDL_MAX_UINT32;
+    }
+    
+    if (stream->buffer != NULL) {
+        SDL_ReleaseGPUBuffer(device, stream->buffer);
+    }
+    if (stream->transferBuffer != NULL) {
+        SDL_ReleaseGPUTransferBuffer(device, stream->transferBuffer);
+    }
+    stream->transferBuffer = NULL;
+    stream->size = 0;
+    
+    stream->buffer = SDL_CreateGPUBuffer(
+        device,
+        &(SDL_GPUBufferCreateInfo) {
+            .usageFlags = stream->usage,
+            .sizeInBytes = (Uint32) capacity
+        }
+    );
+    if (stream->buffer == NULL) {
+        SDL_Log("Failed to create %s", stream->name);
+        return 0;
+    }
+    SDL_SetGPUBufferName(
+        device,
+        stream->buffer,
+        stream->name
+    );
+    
+    stream->transferBuffer = SDL_CreateGPUTransferBuffer(
+        device,
+        &(SDL_GPUTransferBufferCreateInfo) {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .sizeInBytes = (Uint32) capacity
+        }
+    );
+    if (stream->transferBuffer == NULL) {
+        SDL_Log("Failed to create transfer buffer for %s", stream->name);
+        return 0;
+    }
+    
+    stream->size = (Uint32) capacity;
+    
+    return 1;
+}
+
+static void SpriteBatch_Upload_Buffer(
+    SDL_GPUCopyPass* copyPass,
+    SpriteBatch_Buffer* stream,
+    Uint32 size
+) {
+    if (size == 0) {
+        return;
+    }
+    
+    SDL_UploadToGPUBuffer(
+        copyPass,
+        &(SDL_GPUTransferBufferLocation) {
+            .transferBuffer = stream->transferBuffer,
+            .offset = 0
+        },
+        &(SDL_GPUBufferRegion) {
+            .buffer = stream->buffer,
+            .offset = 0,
+            .size = size
+        },
+        SDL_TRUE
+    );
+    frameStats.uploadBytes += size;
+}
+
+static void SpriteBatch_Release_Buffer(SpriteBatch_Buffer* stream)
+{
+    if (stream->buffer != NULL) {
+        SDL_ReleaseGPUBuffer(device, stream->buffer);
+    }
+    if (stream->transferBuffer != NULL) {
+        SDL_ReleaseGPUTransferBuffer(device, stream->transferBuffer);
+    }
+    stream->buffer = NULL;
+    stream->transferBuffer = NULL;
+    stream->size = 0;
+}
+
+static int Pipeline_Mode(SDL_GPUGraphicsPipeline* pipeline)
+{
+    for (int i = 0; i < pipelineInfoCount; i++) {
+        if (pipelineInfos[i].pipeline == pipeline) {
+            return pipelineInfos[i].mode;
+        }
+    }
+    
+    return PIPELINE_MODE_VERTEX;
+}
+
+static char Pipeline_Opaque(SDL_GPUGraphicsPipeline* pipeline)
+{
+    for (int i = 0; i < pipelineInfoCount; i++) {
+        if (pipelineInfos[i].pipeline == pipeline) {
+            return pipelineInfos[i].opaque;
+        }
+    }
+    
+    return 0;
+}
+
+static SDL_GPUGraphicsPipeline* Pipeline_Create(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader,
+    SDL_GPUVertexInputState vertexInputState,
+    int mode,
+    char opaque
+) {
+    // The vertex input follows from the mode, so this is the whole create
+    // info
+    const SDL_GPUTextureFormat format = RenderTarget_Format();
+    for (int i = 0; i < pipelineInfoCount; i++) {
+        Pipeline_Info* cached = &pipelineInfos[i];
+        if (
+            cached->vertexShader == vertexShader
+            && cached->fragmentShader == fragmentShader
+            && cached->mode == mode
+            && cached->opaque == opaque
+            && cached->depth == depthEnabled
+            && cached->format == format
+        ) {
+            cached->references++;
+            return cached->pipeline;
+        }
+    }
+    
+    if (pipelineInfoCount == SPRITE_PIPELINE_MAX) {
+        SDL_Log("Too many pipelines");
+        return NULL;
+    }
+    
+    SDL_GPUGraphicsPipelineCreateInfo info = {
+        .attachmentInfo = {
+            .colorAttachmentCount = 1,
+            .colorAttachmentDescriptions = (SDL_GPUColorAttachmentDescription[]){{
+                .format = format,
+                .blendState = {
+                    .blendEnable = opaque ? SDL_FALSE : SDL_TRUE,
+                    .alphaBlendOp = SDL_GPU_BLENDOP_ADD,
+                    .colorBlendOp = SDL_GPU_BLENDOP_ADD,
+                    .colorWriteMask = 0xF,
+                    .srcColorBlendFactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .srcAlphaBlendFactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .dstColorBlendFactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .dstAlphaBlendFactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                }
+            }},
+            .hasDepthStencilAttachment = depthEnabled ? SDL_TRUE : SDL_FALSE,
+            .depthStencilFormat = DEPTH_FORMAT,
+        },
+        .vertexInputState = vertexInputState,
+        .multisampleState.sampleMask = 0xFFFF,
+        .primitiveType = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .vertexShader = vertexShader,
+        .fragmentShader = fragmentShader,
+        // Equal depths pass, so within a layer the last staged sprite still
+        // ends up on top
+        .depthStencilState = {
+            .depthTestEnable = depthEnabled ? SDL_TRUE : SDL_FALSE,
+            .depthWriteEnable = opaque ? SDL_TRUE : SDL_FALSE,
+            .compareOp = SDL_GPU_COMPAREOP_LESS_OR_EQUAL,
+        },
+    };
+    
+    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(
+        device,
+        &info
+    );
+    
+    if (pipeline != NULL) {
+        pipelineInfos[pipelineInfoCount++] = (Pipeline_Info) {
+            .pipeline = pipeline,
+            .vertexShader = vertexShader,
+            .fragmentShader = fragmentShader,
+            .mode = mode,
+            .opaque = opaque,
+            .depth = depthEnabled,
+            .format = format,
+            .references = 1,
+        };
+    }
+    
+    return pipeline;
+}
+
+static int SpriteBatch_Find_Slot(void** slots, int* slotCount, int maxSlots, void* value)
+{
+    // Searching backwards finds the most recently added texture first
+    for (int i = *slotCount - 1; i >= 0; i--) {
+        if (slots[i] == value) {
+            return i;
+        }
+    }
+    
+    if (*slotCount == maxSlots) {
+        return -1;
+    }
+    
+    slots[*slotCount] = value;
+    
+    return (*slotCount)++;
+}
+
+static int SpriteBatch_Compare_Keys(const void* a, const void* b)
+{
+    const Uint64 keyA = *(const Uint64*) a;
+    const Uint64 keyB = *(const Uint64*) b;
+    
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+/**
+ * Drop the keys of sprites outside their view's rectangle. The test is
+ * branch-free over the staging array so it vectorizes; keys still match
+ * sprites one to one at this point.
+ */
+static void SpriteBatch_Cull(void)
+{
+    const int spriteCount = batchViewSpriteCount;
+    if (spriteCount > cullKeepCapacity) {
+        Uint8* keep = SDL_realloc(cullKeep, spriteCount);
+        if (keep == NULL) {
+            SDL_Log("Failed to allocate cull buffer, skipping culling");
+            return;
+        }
+        cullKeep = keep;
+        cullKeepCapacity = spriteCount;
+    }
+    
+    float viewMinX[SPRITE_VIEW_MAX], viewMinY[SPRITE_VIEW_MAX];
+    float viewMaxX[SPRITE_VIEW_MAX], viewMaxY[SPRITE_VIEW_MAX];
+    for (int v = 0; v < batchViewCount; v++) {
+        const SpriteBatch_View* view = &batchViews[v];
+        if (view->replayed) {
+            viewMinX[v] = viewMinY[v] = -SDL_MAX_SINT32;
+            viewMaxX[v] = viewMaxY[v] = SDL_MAX_SINT32;
+            continue;
+        }
+        
+        viewMinX[v] = view->position.x - cullMargin;
+        viewMinY[v] = view->position.y - cullMargin;
+        viewMaxX[v] = view->position.x + view->size.x + cullMargin;
+        viewMaxY[v] = view->position.y + view->size.y + cullMargin;
+    }
+    
+    const SpriteBatch_Dest* dest = spriteBatch.dest;
+    for (int i = 0; i < spriteCount; i++) {
+        const int v = SPRITE_KEY_FIELD(spriteBatchKeys[i], SPRITE_KEY_VIEW_SHIFT, 8);
+        const float x0 = dest[i].destPos.x;
+        const float y0 = dest[i].destPos.y;
+        const float x1 = x0 + dest[i].destSize.x;
+        const float y1 = y0 + dest[i].destSize.y;
+        // Sizes may be negative for flipped sprites
+        cullKeep[i] = (SDL_min(x0, x1) <= viewMaxX[v])
+            & (SDL_max(x0, x1) >= viewMinX[v])
+            & (SDL_min(y0, y1) <= viewMaxY[v])
+            & (SDL_max(y0, y1) >= viewMinY[v]);
+    }
+    
+    // A rotated sprite stays within its diagonal of its pivot, which is
+    // inside the rectangle
+    if (spriteBatch.rotation != NULL) {
+        for (int i = 0; i < spriteCount; i++) {
+            if (spriteBatch.rotation[i].angle == 0 || cullKeep[i]) {
+                continue;
+            }
+            
+            const int v = SPRITE_KEY_FIELD(spriteBatchKeys[i], SPRITE_KEY_VIEW_SHIFT, 8);
+            const float2 size = dest[i].destSize;
+            const float pad = SDL_fabsf(size.x) + SDL_fabsf(size.y);
+            const float x0 = dest[i].destPos.x;
+            const float y0 = dest[i].destPos.y;
+            const float x1 = x0 + size.x;
+            const float y1 = y0 + size.y;
+            cullKeep[i] = (SDL_min(x0, x1) - pad <= viewMaxX[v])
+                & (SDL_max(x0, x1) + pad >= viewMinX[v])
+                & (SDL_min(y0, y1) - pad <= viewMaxY[v])
+                & (SDL_max(y0, y1) + pad >= viewMinY[v]);
+        }
+    }
+    
+    int kept = 0;
+    for (int i = 0; i < spriteCount; i++) {
+        spriteBatchKeys[kept] = spriteBatchKeys[i];
+        kept += cullKeep[i];
+    }
+    
+    frameStats.spritesCulled = spriteCount - kept;
+    batchViewSpriteCount = kept;
+}
+
+/**
+ * With depth on, rewrite the keys so the sprites of opaque pipelines sort
+ * ahead of the rest of their view, front to back. Everything they cover is
+ * then rejected by the depth test before it is shaded.
+ */
+static void SpriteBatch_Order_Opaque(void)
+{
+    char slotOpaque[SPRITE_PIPELINE_MAX] = { 0 };
+    for (int i = 1; i < batchPipelineCount; i++) {
+        slotOpaque[i] = Pipeline_Opaque(batchPipelines[i]);
+    }
+    char viewOpaque[SPRITE_VIEW_MAX];
+    for (int v = 0; v < batchViewCount; v++) {
+        viewOpaque[v] = Pipeline_Opaque(batchViews[v].pipeline);
+    }
+    
+    const Uint64 layerMask = (Uint64) SPRITE_LAYER_MAX << SPRITE_KEY_LAYER_SHIFT;
+    const Uint64 blended = 1ull << SPRITE_KEY_BLENDED_SHIFT;
+    for (int i = 0; i < batchViewSpriteCount; i++) {
+        const Uint64 key = spriteBatchKeys[i];
+        const int pipelineSlot = SPRITE_KEY_FIELD(key, SPRITE_KEY_PIPELINE_SHIFT, 7);
+        const char opaque = pipelineSlot
+            ? slotOpaque[pipelineSlot]
+            : viewOpaque[SPRITE_KEY_FIELD(key, SPRITE_KEY_VIEW_SHIFT, 8)];
+        if (!opaque) {
+            spriteBatchKeys[i] = key | blended;
+            continue;
+        }
+        
+        const Uint64 layer = SPRITE_KEY_FIELD(key, SPRITE_KEY_LAYER_SHIFT, 12);
+        spriteBatchKeys[i] = (key & ~layerMask) | ((SPRITE_LAYER_MAX - layer) << SPRITE_KEY_LAYER_SHIFT);
+    }
+}
+
+/**
+ * Sort the staged sprites by key & split them into `batchDraws`, assigning
+ * each draw its place in the vertex or instance stream.
+ *
+ * @return  int the largest indexed draw, in sprites
+ */
+static int SpriteBatch_Sort(void)
+{
+    const int spriteCount = batchViewSpriteCount;
+    
+    char inOrder = 1;
+    for (int i = 1; i < spriteCount; i++) {
+        if (spriteBatchKeys[i] < spriteBatchKeys[i - 1]) {
+            inOrder = 0;
+            break;
+        }
+    }
+    
+    if (!inOrder) {
+        SDL_qsort(spriteBatchKeys, spriteCount, sizeof(Uint64), SpriteBatch_Compare_Keys);
+    }
+    
+    const Uint64 stateMask = ~((1ull << SPRITE_KEY_SPRITE_BITS) - 1);
+    int largestDraw = 0;
+    batchDrawCount = 0;
+    batchVertexSpriteCount = 0;
+    batchInstanceCount = 0;
+    batchStorageCount = 0;
+    
+    for (int first = 0; first < spriteCount; ) {
+        const Uint64 state = spriteBatchKeys[first] & stateMask;
+        int last = first + 1;
+        while (last < spriteCount && (spriteBatchKeys[last] & stateMask) == state) {
+            last++;
+        }
+        
+        if (batchDrawCount == batchDrawCapacity) {
+            const int capacity = batchDrawCapacity ? batchDrawCapacity * 2 : 64;
+            SpriteBatch_Draw* draws = SDL_realloc(batchDraws, sizeof(SpriteBatch_Draw) * capacity);
+            if (draws == NULL) {
+                SDL_Log("Failed to grow draw list, dropping sprites");
+                break;
+            }
+            batchDraws = draws;
+            batchDrawCapacity = capacity;
+        }
+        
+        SpriteBatch_View* view = &batchViews[SPRITE_KEY_FIELD(state, SPRITE_KEY_VIEW_SHIFT, 8)];
+        if (view->drawCount == 0) {
+            view->firstDraw = batchDrawCount;
+        }
+        view->drawCount++;
+        
+        const int pipelineSlot = SPRITE_KEY_FIELD(state, SPRITE_KEY_PIPELINE_SHIFT, 7);
+        const int mode = Pipeline_Mode(pipelineSlot ? batchPipelines[pipelineSlot] : view->pipeline);
+        int offset;
+        if (mode == PIPELINE_MODE_INSTANCED) {
+            offset = batchInstanceCount;
+            batchInstanceCount += last - first;
+        } else if (mode == PIPELINE_MODE_STORAGE) {
+            offset = batchStorageCount;
+            batchStorageCount += last - first;
+        } else {
+            offset = batchVertexSpriteCount;
+            batchVertexSpriteCount += last - first;
+            if (last - first > largestDraw) {
+                largestDraw = last - first;
+            }
+        }
+        
+        batchDraws[batchDrawCount++] = (SpriteBatch_Draw) {
+            .key = state,
+            .first = first,
+            .count = last - first,
+            .mode = mode,
+            .offset = offset,
+        };
+        
+        first = last;
+    }
+    
+    return largestDraw;
+}
+
+static char SpriteBatch_Rotated(const SpriteBatch_Store* store, int sprite)
+{
+    return store->rotation != NULL && store->rotation[sprite].angle != 0;
+}
+
+static void SpriteBatch_Write_Quad(Vertex* vertices, const SpriteBatch_Store* store, int sprite, float z)
+{
+    const SpriteBatch_Dest* dest = &store->dest[sprite];
+    const SpriteBatch_Source* source = &store->source[sprite];
+    const float x0 = dest->destPos.x;
+    const float y0 = dest->destPos.y;
+    const float x1 = x0 + dest->destSize.x;
+    const float y1 = y0 + dest->destSize.y;
+    const float u0 = source->sourcePos.x;
+    const float v0 = source->sourcePos.y;
+    const float u1 = u0 + source->sourceSize.x;
+    const float v1 = v0 + source->sourceSize.y;
+    const Color color = source->color;
+    
+    float2 corners[4] = {
+        { x0, y0 },
+        { x1, y0 },
+        { x1, y1 },
+        { x0, y1 },
+    };
+    if (SpriteBatch_Rotated(store, sprite)) {
+        const SpriteBatch_Rotation* rotation = &store->rotation[sprite];
+        const float pivotX = x0 + rotation->origin.x;
+        const float pivotY = y0 + rotation->origin.y;
+        const float c = SDL_cosf(rotation->angle);
+        const float s = SDL_sinf(rotation->angle);
+        for (int i = 0; i < 4; i++) {
+            const float dx = corners[i].x - pivotX;
+            const float dy = corners[i].y - pivotY;
+            corners[i] = (float2){
+                .x = pivotX + dx * c - dy * s,
+                .y = pivotY + dx * s + dy * c,
+            };
+        }
+    }
+    
+    vertices[0] = (Vertex) {
+        .x = corners[0].x,
+        .y = corners[0].y,
+        .z = z,
+        .u = u0,
+        .v = v0,
+        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
+    };
+    vertices[1] = (Vertex) {
+        .x = corners[1].x,
+        .y = corners[1].y,
+        .z = z,
+        .u = u1,
+        .v = v0,
+        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
+    };
+    vertices[2] = (Vertex) {
+        .x = corners[2].x,
+        .y = corners[2].y,
+        .z = z,
+        .u = u1,
+        .v = v1,
+        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
+    };
+    vertices[3] = (Vertex) {
+        .x = corners[3].x,
+        .y = corners[3].y,
+        .z = z,
+        .u = u0,
+        .v = v1,
+        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
+    };
+}
+
+/**
+ * Write the quads of `count` sprites, in the order of their `keys`, straight
+ * into a mapped transfer buffer, all at depth `z`. The kernels below all
+ * produce the same vertices; `TinyDraw_Init` picks the fastest one the CPU
+ * supports. Rotated sprites always take the scalar path.
+ */
+typedef void (*SpriteBatch_Quad_Kernel)(
+    Vertex* vertices,
+    const SpriteBatch_Store* store,
+    const Uint64* keys,
+    int count,
+    float z
+);
+
+static void SpriteBatch_Write_Quads_Scalar(
+    Vertex* vertices,
+    const SpriteBatch_Store* store,
+    const Uint64* keys,
+    int count,
+    float z
+) {
+    const Uint64 spriteMask = (1ull << SPRITE_KEY_SPRITE_BITS) - 1;
+    
+    for (int i = 0; i < count; i++) {
+        SpriteBatch_Write_Quad(&vertices[i * 4], store, (int) (keys[i] & spriteMask), z);
+    }
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+/**
+ * Each sprite is loaded as its destination rect, source rect & color, which
+ * give the (x, y, u, v) of its top-left & bottom-right corners, & shuffled
+ * into the 9 vectors of its quad. A quad is 144 bytes, so in an aligned
+ * buffer each starts on a 16-byte boundary & is written with streaming
+ * stores, which skip reading the lines they overwrite.
+ */
+static void SpriteBatch_Write_Quads_SSE2(
+    Vertex* vertices,
+    const SpriteBatch_Store* store,
+    const Uint64* keys,
+    int count,
+    float z
+) {
+    const Uint64 spriteMask = (1ull << SPRITE_KEY_SPRITE_BITS) - 1;
+    const __m128 depth = _mm_set1_ps(z);
+    const char aligned = ((uintptr_t) vertices & 15) == 0;
+    
+    for (int i = 0; i < count; i++) {
+        const int s = (int) (keys[i] & spriteMask);
+        if (SpriteBatch_Rotated(store, s)) {
+            SpriteBatch_Write_Quad(&vertices[i * 4], store, s, z);
+            continue;
+        }
+        
+        const SpriteBatch_Source* source = &store->source[s];
+        const __m128 dest = _mm_loadu_ps(&store->dest[s].destPos.x);
+        const __m128 sourceRect = _mm_loadu_ps(&source->sourcePos.x);
+        const __m128 color = _mm_loadu_ps(&source->color.r);
+        // (x0, y0, u0, v0) & (x1, y1, u1, v1)
+        const __m128 low = _mm_movelh_ps(dest, sourceRect);
+        const __m128 high = _mm_add_ps(low, _mm_movehl_ps(sourceRect, dest));
+        
+        // Vertices are (x, y, z, u, v, r, g, b, a), corners in the order
+        // top-left, top-right, bottom-right, bottom-left
+        const __m128 zU0 = _mm_shuffle_ps(depth, low, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 zU1 = _mm_shuffle_ps(depth, high, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 v0R = _mm_shuffle_ps(low, color, _MM_SHUFFLE(0, 0, 3, 3));
+        const __m128 aX1 = _mm_shuffle_ps(color, high, _MM_SHUFFLE(0, 0, 3, 3));
+        const __m128 y0Z = _mm_shuffle_ps(low, depth, _MM_SHUFFLE(0, 0, 1, 1));
+        const __m128 u1V0 = _mm_shuffle_ps(high, low, _MM_SHUFFLE(3, 3, 2, 2));
+        const __m128 v1R = _mm_shuffle_ps(high, color, _MM_SHUFFLE(0, 0, 3, 3));
+        const __m128 aX0 = _mm_shuffle_ps(color, low, _MM_SHUFFLE(0, 0, 3, 3));
+        const __m128 y1Z = _mm_shuffle_ps(high, depth, _MM_SHUFFLE(0, 0, 1, 1));
+        const __m128 u0V1 = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 3, 2, 2));
+        const __m128 quad[9] = {
+            _mm_shuffle_ps(low, zU0, _MM_SHUFFLE(2, 0, 1, 0)),
+            _mm_shuffle_ps(v0R, color, _MM_SHUFFLE(2, 1, 2, 0)),
+            _mm_shuffle_ps(aX1, y0Z, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm_shuffle_ps(u1V0, color, _MM_SHUFFLE(1, 0, 2, 0)),
+            _mm_shuffle_ps(color, high, _MM_SHUFFLE(1, 0, 3, 2)),
+            _mm_shuffle_ps(zU1, v1R, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm_shuffle_ps(color, aX0, _MM_SHUFFLE(2, 0, 2, 1)),
+            _mm_shuffle_ps(y1Z, u0V1, _MM_SHUFFLE(2, 0, 2, 0)),
+            color,
+        };
+        
+        float* out = (float*) &vertices[i * 4];
+        if (aligned) {
+            for (int q = 0; q < 9; q++) {
+                _mm_stream_ps(&out[q * 4], quad[q]);
+            }
+        } else {
+            for (int q = 0; q < 9; q++) {
+                _mm_storeu_ps(&out[q * 4], quad[q]);
+            }
+        }
+    }
+    
+    // Streaming stores aren't ordered with the rest, so they must land
+    // before the buffer is unmapped
+    _mm_sfence();
+}
+#endif
+
+#ifdef SDL_NEON_INTRINSICS
+/**
+ * Same layout as the SSE2 kernel, with `vbslq` selecting the corners.
+ */
+static void SpriteBatch_Write_Quads_NEON(
+    Vertex* vertices,
+    const SpriteBatch_Store* store,
+    const Uint64* keys,
+    int count,
+    float z
+) {
+    const Uint64 spriteMask = (1ull << SPRITE_KEY_SPRITE_BITS) - 1;
+    static const uint32_t cornerBits[4][4] = {
+        { 0, 0, 0, 0 },
+        { ~0u, 0, ~0u, 0 },
+        { ~0u, ~0u, ~0u, ~0u },
+        { 0, ~0u, 0, ~0u },
+    };
+    uint32x4_t corners[4];
+    for (int c = 0; c < 4; c++) {
+        corners[c] = vld1q_u32(cornerBits[c]);
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const int s = (int) (keys[i] & spriteMask);
+        if (SpriteBatch_Rotated(store, s)) {
+            SpriteBatch_Write_Quad(&vertices[i * 4], store, s, z);
+            continue;
+        }
+        
+        const SpriteBatch_Source* source = &store->source[s];
+        float* out = (float*) &vertices[i * 4];
+        const float32x4_t dest = vld1q_f32(&store->dest[s].destPos.x);
+        const float32x4_t sourceRect = vld1q_f32(&source->sourcePos.x);
+        const float32x4_t color = vld1q_f32(&source->color.r);
+        const float32x4_t low = vcombine_f32(vget_low_f32(dest), vget_low_f32(sourceRect));
+        const float32x4_t high = vaddq_f32(
+            low,
+            vcombine_f32(vget_high_f32(dest), vget_high_f32(sourceRect))
+        );
+        
+        for (int c = 0; c < 4; c++) {
+            const float32x4_t corner = vbslq_f32(corners[c], high, low);
+            float32x4_t first = vsetq_lane_f32(z, corner, 2);
+            first = vsetq_lane_f32(vgetq_lane_f32(corner, 2), first, 3);
+            
+            vst1q_f32(&out[c * 9], first);
+            vst1q_f32(&out[c * 9 + 4], vextq_f32(corner, color, 3));
+            out[c * 9 + 8] = source->color.a;
+        }
+    }
+}
+#endif
+
+static SpriteBatch_Quad_Kernel spriteBatchWriteQuads = SpriteBatch_Write_Quads_Scalar;
+
+static void SpriteBatch_Select_Kernel(void)
+{
+    spriteBatchWriteQuads = SpriteBatch_Write_Quads_Scalar;
+#ifdef SDL_SSE2_INTRINSICS
+    if (SDL_HasSSE2()) {
+        spriteBatchWriteQuads = SpriteBatch_Write_Quads_SSE2;
+    }
+#endif
+#ifdef SDL_NEON_INTRINSICS
+    if (SDL_HasNEON()) {
+        spriteBatchWriteQuads = SpriteBatch_Write_Quads_NEON;
+    }
+#endif
+}
+
+static Uint16 Unorm16(float value)
+{
+    return (Uint16) (SDL_clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+static Uint8 Unorm8(float value)
+{
+    return (Uint8) (SDL_clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static void SpriteBatch_Write_Instance(SpriteInstance* instance, const SpriteBatch_Store* store, int sprite)
+{
+    const SpriteBatch_Dest* dest = &store->dest[sprite];
+    const SpriteBatch_Source* source = &store->source[sprite];
+    *instance = (SpriteInstance) {
+        .x = dest->destPos.x,
+        .y = dest->destPos.y,
+        .w = dest->destSize.x,
+        .h = dest->destSize.y,
+        .u = Unorm16(source->sourcePos.x),
+        .v = Unorm16(source->sourcePos.y),
+        .uw = Unorm16(source->sourceSize.x),
+        .vh = Unorm16(source->sourceSize.y),
+        .r = Unorm8(source->color.r),
+        .g = Unorm8(source->color.g),
+        .b = Unorm8(source->color.b),
+        .a = Unorm8(source->color.a),
+    };
+}
+
+/**
+ * Write the sorted sprites of every draw into its stream.
+ */
+static void SpriteBatch_Pack(
+    Vertex* vertexData,
+    SpriteInstance* instanceData,
+    SpriteInstance* storageData
+) {
+    const Uint64 spriteMask = (1ull << SPRITE_KEY_SPRITE_BITS) - 1;
+    char droppedRotated = 0;
+    
+    for (int d = 0; d < batchDrawCount; d++) {
+        const SpriteBatch_Draw* draw = &batchDraws[d];
+        
+        if (draw->mode == PIPELINE_MODE_VERTEX) {
+            spriteBatchWriteQuads(
+                &vertexData[draw->offset * 4],
+                &spriteBatch,
+                &spriteBatchKeys[draw->first],
+                draw->count,
+                Sprite_Depth(SpriteBatch_Key_Layer(draw->key))
+            );
+            continue;
+        }
+        
+        SpriteInstance* instances = draw->mode == PIPELINE_MODE_INSTANCED
+            ? &instanceData[draw->offset]
+            : &storageData[draw->offset];
+        for (int i = 0; i < draw->count; i++) {
+            const int sprite = (int) (spriteBatchKeys[draw->first + i] & spriteMask);
+            
+            // Instances carry no rotation, so a rotated sprite becomes an
+            // empty quad rather than being drawn wrong
+            if (SpriteBatch_Rotated(&spriteBatch, sprite)) {
+                instances[i] = (SpriteInstance) { 0 };
+                droppedRotated = 1;
+                continue;
+            }
+            
+            SpriteBatch_Write_Instance(&instances[i], &spriteBatch, sprite);
+        }
+    }
+    
+    if (droppedRotated) {
+        SDL_Log("Instanced & storage pipelines can't rotate sprites, dropping rotated sprites");
+    }
+}
+
+static void SpriteBatch_Reset(void)
+{
+    spriteBatchCount = 0;
+    batchTextureCount = 0;
+    batchPipelineCount = 1;
+    batchDrawCount = 0;
+    batchViewCount = 0;
+    batchLastRender = -1;
+    batchViewSpriteCount = 0;
+    batchStaticCount = 0;
+    batchViewStaticCount = 0;
+    batchTargetCount = 0;
+    batchPassCount = 0;
+    transientTargetCount = 0;
+}
+
+/**
+ * Grow a store & its keys to hold at least `needed` sprites.
+ */
+static int SpriteBatch_Store_Grow(
+    SpriteBatch_Store* store,
+    Uint64** keys,
+    int* capacity,
+    Sint64 needed
+) {
+    if (needed <= *capacity) {
+        return 1;
+    }
+    
+    if (needed > (Sint64) SPRITE_COUNT_MAX) {
+        SDL_Log("Sprite batch is full, dropping sprites");
+        return 0;
+    }
+    
+    int newCapacity = *capacity ? *capacity : SPRITE_COUNT;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+    
+    SpriteBatch_Dest* dest = SDL_realloc(store->dest, sizeof(SpriteBatch_Dest) * newCapacity);
+    if (dest == NULL) {
+        SDL_Log("Failed to grow sprite batch, dropping sprites");
+        return 0;
+    }
+    store->dest = dest;
+    
+    SpriteBatch_Source* source = SDL_realloc(store->source, sizeof(SpriteBatch_Source) * newCapacity);
+    if (source == NULL) {
+        SDL_Log("Failed to grow sprite batch, dropping sprites");
+        return 0;
+    }
+    store->source = source;
+    
+    if (store->rotation != NULL) {
+        SpriteBatch_Rotation* rotation = SDL_realloc(
+            store->rotation,
+            sizeof(SpriteBatch_Rotation) * newCapacity
+        );
+        if (rotation == NULL) {
+            SDL_Log("Failed to grow sprite batch, dropping sprites");
+            return 0;
+        }
+        store->rotation = rotation;
+    }
+    
+    Uint64* newKeys = SDL_realloc(*keys, sizeof(Uint64) * newCapacity);
+    if (newKeys == NULL) {
+        SDL_Log("Failed to grow sprite batch, dropping sprites");
+        return 0;
+    }
+    *keys = newKeys;
+    *capacity = newCapacity;
+    
+    return 1;
+}
+
+/**
+ * Make room for `count` more staged sprites.
+ */
+static int SpriteBatch_Grow(int count)
+{
+    return SpriteBatch_Store_Grow(
+        &spriteBatch,
+        &spriteBatchKeys,
+        &spriteBatchCapacity,
+        (Sint64) spriteBatchCount + count
+    );
+}
+
+/**
+ * Allocate the rotations, unrotated for the sprites already staged.
+ */
+static int SpriteBatch_Enable_Rotation(void)
+{
+    spriteBatch.rotation = SDL_calloc(spriteBatchCapacity, sizeof(SpriteBatch_Rotation));
+    if (spriteBatch.rotation == NULL) {
+        SDL_Log("Failed to allocate sprite rotations");
+        return 0;
+    }
+    
+    return 1;
+}
+
+static void SpriteBatch_Store_Free(SpriteBatch_Store* store)
+{
+    SDL_free(store->dest);
+    SDL_free(store->source);
+    SDL_free(store->rotation);
+    *store = (SpriteBatch_Store) { 0 };
+}
+
+static void SpriteBatch_Store_Set(
+    SpriteBatch_Store* store,
+    int sprite,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    Color color
+) {
+    store->dest[sprite] = (SpriteBatch_Dest) {
+        .destPos = destPos,
+        .destSize = destSize,
+    };
+    store->source[sprite] = (SpriteBatch_Source) {
+        .sourcePos = sourcePos,
+        .sourceSize = sourceSize,
+        .color = color,
+    };
+    if (store->rotation != NULL) {
+        store->rotation[sprite] = (SpriteBatch_Rotation) { 0 };
+    }
+}
+
+/**
+ * Bytes of one mip level, in whole 4x4 blocks for block compressed formats.
+ */
+static Uint64 Texture_Level_Size(SDL_GPUTextureFormat format, Uint32 width, Uint32 height)
+{
+    const Uint64 blocks = (Uint64) ((width + 3) / 4) * ((height + 3) / 4);
+    switch (format) {
+        case SDL_GPU_TEXTUREFORMAT_BC1_UNORM: {
+            return blocks * 8;
+        }
+        
+        case SDL_GPU_TEXTUREFORMAT_BC3_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC7_UNORM: {
+            return blocks * 16;
+        }
+        
+        default: {
+            return (Uint64) width * height * 4;
+        }
+    }
+}
+
+/**
+ * Bytes of a whole mip chain.
+ */
+static Uint64 Texture_Size(SDL_GPUTextureFormat format, Uint32 width, Uint32 height, Uint32 levelCount)
+{
+    Uint64 size = 0;
+    for (Uint32 level = 0; level < levelCount; level++) {
+        size += Texture_Level_Size(format, SDL_max(width >> level, 1), SDL_max(height >> level, 1));
+    }
+    
+    return size;
+}
+
+/**
+ * Levels of a full mip chain, down to 1x1.
+ */
+static Uint32 Texture_Level_Count(Uint32 width, Uint32 height)
+{
+    Uint32 levelCount = 1;
+    while ((width >> levelCount) > 0 || (height >> levelCount) > 0) {
+        levelCount++;
+    }
+    
+    return levelCount;
+}
+
+/**
+ * Fill the mip levels after the first of an RGBA chain, averaging 2x2
+ * blocks with colors weighted by alpha, so transparent texels don't darken
+ * the edges of a sprite.
+ */
+static void Texture_Build_Mips(Uint8* texels, Uint32 width, Uint32 height, Uint32 levelCount)
+{
+    Uint8* source = texels;
+    for (Uint32 level = 1; level < levelCount; level++) {
+        const int sourceWidth = SDL_max(width >> (level - 1), 1);
+        const int sourceHeight = SDL_max(height >> (level - 1), 1);
+        const int destWidth = SDL_max(width >> level, 1);
+        const int destHeight = SDL_max(height >> level, 1);
+        Uint8* dest = source + sourceWidth * sourceHeight * 4;
+        
+        for (int y = 0; y < destHeight; y++) {
+            for (int x = 0; x < destWidth; x++) {
+                Uint32 sum[4] = { 0 };
+                for (int sample = 0; sample < 4; sample++) {
+                    const int sx = SDL_min(x * 2 + (sample & 1), sourceWidth - 1);
+                    const int sy = SDL_min(y * 2 + (sample >> 1), sourceHeight - 1);
+                    const Uint8* texel = &source[(sy * sourceWidth + sx) * 4];
+                    sum[0] += texel[0] * texel[3];
+                    sum[1] += texel[1] * texel[3];
+                    sum[2] += texel[2] * texel[3];
+                    sum[3] += texel[3];
+                }
+                
+                Uint8* out = &dest[(y * destWidth + x) * 4];
+                for (int c = 0; c < 3; c++) {
+                    out[c] = sum[3] ? (Uint8) ((sum[c] + sum[3] / 2) / sum[3]) : 0;
+                }
+                out[3] = (Uint8) ((sum[3] + 2) / 4);
+            }
+        }
+        
+        source = dest;
+    }
+}
+
+/**
+ * Decode an image to RGBA, with a full mip chain if mipmaps are enabled.
+ *
+ * @return  Uint8*  free with `SDL_free`
+ */
+static Uint8* Texture_Decode(const char* path, int* width, int* height, Uint32* levelCount)
+{
+    int w, h, comp;
+    // Always RGBA, whatever the file holds
+    unsigned char* pixels = stbi_load(path, &w, &h, &comp, 4);
+    if (pixels == NULL) {
+        SDL_Log("Failed to load image `%s`\n", path);
+        return NULL;
+    }
+    
+    const Uint32 levels = samplerMipmaps ? Texture_Level_Count(w, h) : 1;
+    Uint8* texels = SDL_malloc(Texture_Size(SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, w, h, levels));
+    if (texels == NULL) {
+        SDL_Log("Failed to allocate image `%s`", path);
+        stbi_image_free(pixels);
+        return NULL;
+    }
+    SDL_memcpy(texels, pixels, (size_t) w * h * 4);
+    stbi_image_free(pixels);
+    Texture_Build_Mips(texels, w, h, levels);
+    
+    *width = w;
+    *height = h;
+    *levelCount = levels;
+    
+    return texels;
+}
+
+static void TextureLoad_Push(TextureLoad** head, TextureLoad** tail, TextureLoad* load)
+{
+    load->next = NULL;
+    if (*tail != NULL) {
+        (*tail)->next = load;
+    } else {
+        *head = load;
+    }
+    *tail = load;
+}
+
+static int TextureLoad_Worker(void* data)
+{
+    (void) data;
+    
+    SDL_LockMutex(textureLoadMutex);
+    while (1) {
+        while (textureLoadQueue == NULL && !textureLoadQuit) {
+            SDL_WaitCondition(textureLoadQueued, textureLoadMutex);
+        }
+        if (textureLoadQuit) {
+            break;
+        }
+        
+        TextureLoad* load = textureLoadQueue;
+        textureLoadQueue = load->next;
+        if (textureLoadQueue == NULL) {
+            textureLoadQueueTail = NULL;
+        }
+        SDL_UnlockMutex(textureLoadMutex);
+        
+        int w, h;
+        Uint32 levelCount;
+        Uint8* pixels = Texture_Decode(load->path, &w, &h, &levelCount);
+        
+        SDL_LockMutex(textureLoadMutex);
+        if (pixels == NULL) {
+            load->state = TINYDRAW_LOAD_FAILED;
+        } else {
+            load->pixels = pixels;
+            load->width = w;
+            load->height = h;
+            load->levelCount = levelCount;
+            load->size = (Uint32) Texture_Size(SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, w, h, levelCount);
+            load->state = TEXTURE_LOAD_DECODED;
+            TextureLoad_Push(&textureLoadDecodedList, &textureLoadDecodedTail, load);
+        }
+        SDL_BroadcastCondition(textureLoadDecoded);
+    }
+    SDL_UnlockMutex(textureLoadMutex);
+    
+    return 0;
+}
+
+/**
+ * Start the worker threads, once.
+ */
+static int TextureLoad_Start(void)
+{
+    if (textureLoadMutex != NULL) {
+        return 1;
+    }
+    
+    textureLoadMutex = SDL_CreateMutex();
+    textureLoadQueued = SDL_CreateCondition();
+    textureLoadDecoded = SDL_CreateCondition();
+    if (textureLoadMutex == NULL || textureLoadQueued == NULL || textureLoadDecoded == NULL) {
+        SDL_Log("Failed to create texture loader: %s", SDL_GetError());
+        return 0;
+    }
+    
+    // Leave a core for the render thread
+    const int threadCount = SDL_clamp(SDL_GetCPUCount() - 1, 1, TEXTURE_LOAD_THREADS_MAX);
+    textureLoadQuit = 0;
+    for (int i = 0; i < threadCount; i++) {
+        SDL_Thread* thread = SDL_CreateThread(TextureLoad_Worker, "TinyDraw Texture Loader", NULL);
+        if (thread == NULL) {
+            SDL_Log("Failed to create texture loader thread: %s", SDL_GetError());
+            break;
+        }
+        textureLoadThreads[textureLoadThreadCount++] = thread;
+    }
+    
+    return textureLoadThreadCount > 0;
+}
+
+/**
+ * Stop the worker threads. Loads still queued or decoded fail.
+ */
+static void TextureLoad_Stop(void)
+{
+    if (textureLoadMutex == NULL) {
+        return;
+    }
+    
+    SDL_LockMutex(textureLoadMutex);
+    textureLoadQuit = 1;
+    SDL_BroadcastCondition(textureLoadQueued);
+    SDL_UnlockMutex(textureLoadMutex);
+    
+    for (int i = 0; i < textureLoadThreadCount; i++) {
+        SDL_WaitThread(textureLoadThreads[i], NULL);
+    }
+    textureLoadThreadCount = 0;
+    
+    for (TextureLoad* load = textureLoadQueue; load != NULL; load = load->next) {
+        load->state = TINYDRAW_LOAD_FAILED;
+    }
+    for (TextureLoad* load = textureLoadDecodedList; load != NULL; load = load->next) {
+        SDL_free(load->pixels);
+        load->pixels = NULL;
+        load->state = TINYDRAW_LOAD_FAILED;
+    }
+    textureLoadQueue = textureLoadQueueTail = NULL;
+    textureLoadDecodedList = textureLoadDecodedTail = NULL;
+    
+    SDL_DestroyCondition(textureLoadDecoded);
+    SDL_DestroyCondition(textureLoadQueued);
+    SDL_DestroyMutex(textureLoadMutex);
+    textureLoadDecoded = NULL;
+    textureLoadQueued = NULL;
+    textureLoadMutex = NULL;
+}
+
+/**
+ * Create & upload the textures of a list of decoded loads, through one
+ * transfer buffer & one copy pass on `cmdbuf`.
+ */
+static void TextureLoad_Upload(SDL_GPUCommandBuffer* cmdbuf, TextureLoad* loads)
+{
+    Uint32 size = 0;
+    for (TextureLoad* load = loads; load != NULL; load = load->next) {
+        size += load->size;
+    }
+    
+    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(
+        device,
+        &(SDL_GPUTransferBufferCreateInfo) {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .sizeInBytes = size
+        }
+    );
+    Uint8* transferData = transferBuffer != NULL
+        ? SDL_MapGPUTransferBuffer(device, transferBuffer, SDL_FALSE)
+        : NULL;
+    SDL_GPUCopyPass* copyPass = transferData != NULL
+        ? SDL_BeginGPUCopyPass(cmdbuf)
+        : NULL;
+    
+    Uint32 offset = 0;
+    for (TextureLoad* load = loads; load != NULL; load = load->next) {
+        if (copyPass != NULL) {
+            load->texture = SDL_CreateGPUTexture(device, &(SDL_GPUTextureCreateInfo){
+                .type = SDL_GPU_TEXTURETYPE_2D,
+                .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+                .width = load->width,
+                .height = load->height,
+                .layerCountOrDepth = 1,
+                .levelCount = load->levelCount,
+                .usageFlags = SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT
+            });
+        }
+        
+        if (load->texture != NULL) {
+            SDL_memcpy(&transferData[offset], load->pixels, load->size);
+            Uint32 levelOffset = offset;
+            for (Uint32 level = 0; level < load->levelCount; level++) {
+                const Uint32 w = SDL_max(load->width >> level, 1);
+                const Uint32 h = SDL_max(load->height >> level, 1);
+                SDL_UploadToGPUTexture(
+                    copyPass,
+                    &(SDL_GPUTextureTransferInfo) {
+                        .transferBuffer = transferBuffer,
+                        .offset = levelOffset,
+                    },
+                    &(SDL_GPUTextureRegion){
+                        .texture = load->texture,
+                        .mipLevel = level,
+                        .w = w,
+                        .h = h,
+                        .d = 1
+                    },
+                    SDL_FALSE
+                );
+                levelOffset += w * h * 4;
+            }
+        } else {
+            SDL_Log("Failed to upload image `%s`", load->path);
+        }
+        offset += load->size;
+        
+        SDL_free(load->pixels);
+        load->pixels = NULL;
+    }
+    frameStats.uploadBytes += offset;
+    
+    if (copyPass != NULL) {
+        SDL_EndGPUCopyPass(copyPass);
+    }
+    if (transferData != NULL) {
+        SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    }
+    if (transferBuffer != NULL) {
+        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    }
+    
+    SDL_LockMutex(textureLoadMutex);
+    for (TextureLoad* load = loads; load != NULL; load = load->next) {
+        load->state = load->texture != NULL ? TINYDRAW_LOAD_READY : TINYDRAW_LOAD_FAILED;
+    }
+    SDL_UnlockMutex(textureLoadMutex);
+}
+
+/**
+ * Upload the loads decoded since the last frame, up to
+ * `TEXTURE_LOAD_FRAME_BUDGET` bytes.
+ */
+static void TextureLoad_Upload_Decoded(SDL_GPUCommandBuffer* cmdbuf)
+{
+    SDL_LockMutex(textureLoadMutex);
+    TextureLoad* loads = textureLoadDecodedList;
+    TextureLoad* last = loads;
+    Sint64 size = 0;
+    while (last != NULL) {
+        size += last->size;
+        if (last->next == NULL || size + last->next->size > TEXTURE_LOAD_FRAME_BUDGET) {
+            break;
+        }
+        last = last->next;
+    }
+    if (last != NULL) {
+        textureLoadDecodedList = last->next;
+        if (textureLoadDecodedList == NULL) {
+            textureLoadDecodedTail = NULL;
+        }
+        last->next = NULL;
+    }
+    SDL_UnlockMutex(textureLoadMutex);
+    
+    if (loads != NULL) {
+        TextureLoad_Upload(cmdbuf, loads);
+    }
+}
+
+/**
+ * Append a staging context's sprites to the batch for the next view & empty
+ * the context.
+ */
+static void SpriteBatch_Merge_Context(StagingContext* context)
+{
+    const int count = context->count;
+    context->count = 0;
+    if (count == 0 || !SpriteBatch_Grow(count)) {
+        return;
+    }
+    
+    // Only touched by the render thread
+    static int textureSlots[SPRITE_TEXTURE_MAX];
+    static int pipelineSlots[SPRITE_PIPELINE_MAX];
+    for (int i = 0; i < context->textureCount; i++) {
+        textureSlots[i] = SpriteBatch_Find_Slot(
+            batchTextures,
+            &batchTextureCount,
+            SPRITE_TEXTURE_MAX,
+            context->textures[i]
+        );
+    }
+    for (int i = 0; i < context->pipelineCount; i++) {
+        pipelineSlots[i] = SpriteBatch_Find_Slot(
+            batchPipelines,
+            &batchPipelineCount,
+            SPRITE_PIPELINE_MAX,
+            context->pipelines[i]
+        );
+    }
+    context->textureCount = 0;
+    context->pipelineCount = 1;
+    
+    SDL_memcpy(&spriteBatch.dest[spriteBatchCount], context->store.dest, sizeof(SpriteBatch_Dest) * count);
+    SDL_memcpy(&spriteBatch.source[spriteBatchCount], context->store.source, sizeof(SpriteBatch_Source) * count);
+    if (spriteBatch.rotation != NULL) {
+        SDL_memset(&spriteBatch.rotation[spriteBatchCount], 0, sizeof(SpriteBatch_Rotation) * count);
+    }
+    
+    const Uint64 view = (Uint64) batchViewCount << SPRITE_KEY_VIEW_SHIFT;
+    const Uint64 layerMask = (Uint64) SPRITE_LAYER_MAX << SPRITE_KEY_LAYER_SHIFT;
+    int merged = spriteBatchCount;
+    for (int i = 0; i < count; i++) {
+        const Uint64 key = context->keys[i];
+        const int textureSlot = textureSlots[SPRITE_KEY_FIELD(key, SPRITE_KEY_TEXTURE_SHIFT, 12)];
+        const int pipelineSlot = pipelineSlots[SPRITE_KEY_FIELD(key, SPRITE_KEY_PIPELINE_SHIFT, 7)];
+        if (textureSlot < 0 || pipelineSlot < 0) {
+            continue;
+        }
+        
+        // Sprites dropped above leave gaps, so the records move down with the keys
+        if (merged != spriteBatchCount + i) {
+            spriteBatch.dest[merged] = spriteBatch.dest[spriteBatchCount + i];
+            spriteBatch.source[merged] = spriteBatch.source[spriteBatchCount + i];
+        }
+        
+        spriteBatchKeys[merged] = view
+            | (key & layerMask)
+            | ((Uint64) pipelineSlot << SPRITE_KEY_PIPELINE_SHIFT)
+            | ((Uint64) textureSlot << SPRITE_KEY_TEXTURE_SHIFT)
+            | (Uint64) merged;
+        merged++;
+    }
+    if (merged != spriteBatchCount + count) {
+        SDL_Log("Too many textures or pipelines in one batch, dropping sprites");
+    }
+    
+    spriteBatchCount = merged;
+}
+
+/**
+ * Record the sprites staged since the previous view for `renderTarget`.
+ */
+static void SpriteBatch_Record_View(
+    SDL_GPUGraphicsPipeline* pipeline,
+    float3 camera,
+    SDL_GPUTexture* renderTarget,
+    char clear,
+    int source
+) {
+    if (batchViewCount == SPRITE_VIEW_MAX) {
+        SDL_Log("Too many renders in one frame, dropping render");
+        return;
+    }
+    PROFILE_START(start);
+    
+    for (StagingContext* context = stagingContexts; context != NULL; context = context->next) {
+        SpriteBatch_Merge_Context(context);
+    }
+    
+    const int target = SpriteBatch_Find_Slot(
+        batchTargets,
+        &batchTargetCount,
+        SPRITE_VIEW_MAX,
+        renderTarget
+    );
+    
+    if (source >= 0) {
+        batchViews[source].replayed = 1;
+    }
+    
+    const float2 size = Camera_Size(camera, RenderTarget_Size(renderTarget));
+    batchViews[batchViewCount++] = (SpriteBatch_View) {
+        .pipeline = pipeline,
+        .position = camera,
+        .size = size,
+        .camera = Camera_Matrix(camera, size),
+        .target = target,
+        .clear = clear,
+        .firstStatic = batchViewStaticCount,
+        .staticCount = batchStaticCount - batchViewStaticCount,
+        .source = source,
+    };
+    batchViewSpriteCount = spriteBatchCount;
+    batchViewStaticCount = batchStaticCount;
+    PROFILE_STOP(start, profileTicks.render);
+}
+
+static SDL_GPUSampler* Sampler_For_Texture(SDL_GPUTexture* texture)
+{
+    for (int i = 0; i < samplerOverrideCount; i++) {
+        if (samplerOverrides[i].texture == texture) {
+            return samplerOverrides[i].sampler;
+        }
+    }
+    
+    return sampler;
+}
+
+// What a render pass currently has bound
+typedef struct SpriteBatch_Binding
+{
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUTexture* texture;
+    SDL_GPUBuffer* vertexBuffer;
+    SDL_GPUBuffer* indexBuffer;
+    char storageBuffer;
+} SpriteBatch_Binding;
+
+static void SpriteBatch_Bind(
+    SDL_GPURenderPass* renderPass,
+    SpriteBatch_Binding* bound,
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUTexture* texture
+) {
+    if (pipeline != bound->pipeline) {
+        SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+        bound->pipeline = pipeline;
+        frameStats.pipelineBinds++;
+    }
+    
+    if (texture != bound->texture) {
+        SDL_BindGPUFragmentSamplers(
+            renderPass,
+            0,
+            &(SDL_GPUTextureSamplerBinding){ .texture = texture, .sampler = Sampler_For_Texture(texture) },
+            1
+        );
+        bound->texture = texture;
+        frameStats.textureBinds++;
+    }
+}
+
+static void SpriteBatch_Bind_Buffers(
+    SDL_GPURenderPass* renderPass,
+    SpriteBatch_Binding* bound,
+    SDL_GPUBuffer* vertexBuffer,
+    SDL_GPUBuffer* indexBuffer
+) {
+    if (vertexBuffer != bound->vertexBuffer) {
+        SDL_BindGPUVertexBuffers(renderPass, 0, &(SDL_GPUBufferBinding){ .buffer = vertexBuffer, .offset = 0 }, 1);
+        bound->vertexBuffer = vertexBuffer;
+    }
+    
+    if (indexBuffer != NULL && indexBuffer != bound->indexBuffer) {
+        SDL_BindGPUIndexBuffer(
+            renderPass,
+            &(SDL_GPUBufferBinding){ .buffer = indexBuffer, .offset = 0 },
+            indexBuffer == indexBuffer32
+                ? SDL_GPU_INDEXELEMENTSIZE_32BIT
+                : SDL_GPU_INDEXELEMENTSIZE_16BIT
+        );
+        bound->indexBuffer = indexBuffer;
+    }
+}
+
+/**
+ * Issue the draws of the static layers of one view with an `opaque` pipeline
+ * or without. Baked draws are sorted by layer, so opaque ones are issued in
+ * reverse, front to back.
+ *
+ * @return  char    1 if a draw was skipped for a non-vertex pipeline
+ */
+static char SpriteBatch_Draw_Static(
+    SDL_GPURenderPass* renderPass,
+    SpriteBatch_Binding* bound,
+    const SpriteBatch_View* view,
+    char opaque
+) {
+    char dropped = 0;
+    for (int n = 0; n < view->staticCount; n++) {
+        const StaticLayer* layer = batchStaticLayers[opaque
+            ? view->firstStatic + view->staticCount - 1 - n
+            : view->firstStatic + n];
+        for (int m = 0; m < layer->drawCount; m++) {
+            const StaticLayer_Draw* draw = &layer->draws[opaque ? layer->drawCount - 1 - m : m];
+            SDL_GPUGraphicsPipeline* drawPipeline = draw->pipeline
+                ? draw->pipeline
+                : view->pipeline;
+            if (drawPipeline == NULL || Pipeline_Opaque(drawPipeline) != opaque) {
+                continue;
+            }
+            // Static layers only hold vertices
+            if (Pipeline_Mode(drawPipeline) != PIPELINE_MODE_VERTEX) {
+                dropped = 1;
+                continue;
+            }
+            
+            SpriteBatch_Bind(renderPass, bound, drawPipeline, draw->texture);
+            SpriteBatch_Bind_Buffers(renderPass, bound, layer->buffer, indexBuffer);
+            SDL_DrawGPUIndexedPrimitives(renderPass, draw->count * 6, 1, 0, draw->first * 4, 0);
+            frameStats.drawCalls++;
+        }
+    }
+    
+    return dropped;
+}
+
+/**
+ * Issue the sprite draws `first` to `last` of one view.
+ */
+static void SpriteBatch_Draw_Sprites(
+    SDL_GPUCommandBuffer* cmdbuf,
+    SDL_GPURenderPass* renderPass,
+    SpriteBatch_Binding* bound,
+    const SpriteBatch_View* view,
+    int first,
+    int last
+) {
+    for (int i = first; i < last; i++) {
+        const SpriteBatch_Draw* draw = &batchDraws[i];
+        const int pipelineSlot = SPRITE_KEY_FIELD(draw->key, SPRITE_KEY_PIPELINE_SHIFT, 7);
+        const int textureSlot = SPRITE_KEY_FIELD(draw->key, SPRITE_KEY_TEXTURE_SHIFT, 12);
+        SDL_GPUGraphicsPipeline* drawPipeline = pipelineSlot
+            ? batchPipelines[pipelineSlot]
+            : view->pipeline;
+        SDL_GPUBuffer* drawIndexBuffer = draw->count > SPRITE_COUNT_16BIT
+            ? indexBuffer32
+            : indexBuffer;
+        
+        if (
+            drawPipeline == NULL
+            || batchTextures[textureSlot] == NULL
+            || (draw->mode == PIPELINE_MODE_VERTEX && drawIndexBuffer == NULL)
+        ) {
+            continue;
+        }
+        
+        SpriteBatch_Bind(renderPass, bound, drawPipeline, batchTextures[textureSlot]);
+        
+        if (draw->mode == PIPELINE_MODE_STORAGE) {
+            if (!bound->storageBuffer) {
+                SDL_BindGPUVertexStorageBuffers(renderPass, 0, &storageStream.buffer, 1);
+                bound->storageBuffer = 1;
+            }
+            
+            // Padded to the 16 bytes of a std140 uniform block
+            const Uint32 firstSprite[4] = { (Uint32) draw->offset, 0, 0, 0 };
+            SDL_PushGPUVertexUniformData(
+                cmdbuf,
+                1,
+                firstSprite,
+                sizeof(firstSprite)
+            );
+            SDL_DrawGPUPrimitives(renderPass, draw->count * 6, 1, 0, 0);
+        } else if (draw->mode == PIPELINE_MODE_INSTANCED) {
+            // Two triangles per instance, expanded by the vertex shader
+            SpriteBatch_Bind_Buffers(renderPass, bound, instanceStream.buffer, NULL);
+            SDL_DrawGPUPrimitives(renderPass, 6, draw->count, 0, draw->offset);
+        } else {
+            SpriteBatch_Bind_Buffers(renderPass, bound, vertexStream.buffer, drawIndexBuffer);
+            SDL_DrawGPUIndexedPrimitives(renderPass, draw->count * 6, 1, 0, draw->offset * 4, 0);
+        }
+        frameStats.drawCalls++;
+    }
+}
+
+/**
+ * Issue the draws of one view: opaque sprites & then opaque static layers,
+ * front to back, then the other static layers & then the other sprites.
+ * Without depth nothing is opaque, so static layers are drawn beneath every
+ * sprite.
+ *
+ * @return  char    1 if a static draw was skipped, see `SpriteBatch_Draw_Static`
+ */
+static char SpriteBatch_Draw_View(
+    SDL_GPUCommandBuffer* cmdbuf,
+    SDL_GPURenderPass* renderPass,
+    SpriteBatch_Binding* bound,
+    const SpriteBatch_View* view
+) {
+    const int last = view->firstDraw + view->drawCount;
+    int blended = view->firstDraw;
+    while (
+        depthEnabled
+        && blended < last
+        && SPRITE_KEY_FIELD(batchDraws[blended].key, SPRITE_KEY_BLENDED_SHIFT, 1) == 0
+    ) {
+        blended++;
+    }
+    
+    SpriteBatch_Draw_Sprites(cmdbuf, renderPass, bound, view, view->firstDraw, blended);
+    char dropped = SpriteBatch_Draw_Static(renderPass, bound, view, 1);
+    dropped |= SpriteBatch_Draw_Static(renderPass, bound, view, 0);
+    SpriteBatch_Draw_Sprites(cmdbuf, renderPass, bound, view, blended, last);
+    
+    return dropped;
+}
+
+static char SpriteBatch_Reads(const Uint64* reads, int target)
+{
+    return (reads[target / 64] >> (target % 64)) & 1;
+}
+
+/**
+ * Flag in `reads` every render target sampled by the draws of a view.
+ * `slotTargets` maps texture slots to render targets, or -1.
+ */
+static void SpriteBatch_View_Reads(
+    const SpriteBatch_View* view,
+    const int* slotTargets,
+    Uint64* reads
+) {
+    for (int i = view->firstDraw; i < view->firstDraw + view->drawCount; i++) {
+        const int target = slotTargets[SPRITE_KEY_FIELD(batchDraws[i].key, SPRITE_KEY_TEXTURE_SHIFT, 12)];
+        if (target >= 0) {
+            reads[target / 64] |= 1ull << (target % 64);
+        }
+    }
+    
+    for (int s = view->firstStatic; s < view->firstStatic + view->staticCount; s++) {
+        const StaticLayer* layer = batchStaticLayers[s];
+        for (int i = 0; i < layer->drawCount; i++) {
+            for (int target = 0; target < batchTargetCount; target++) {
+                if (batchTargets[target] == layer->draws[i].texture) {
+                    reads[target / 64] |= 1ull << (target % 64);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Whether view `u`, recorded before view `v`, has to be drawn before it: it
+ * draws into the same target, into a target `v` samples, or samples the
+ * target of `v`.
+ */
+static char SpriteBatch_Depends(int u, int v, Uint64 (*reads)[SPRITE_VIEW_MAX / 64])
+{
+    const int targetU = batchViews[u].target;
+    const int targetV = batchViews[v].target;
+    
+    return targetU == targetV
+        || SpriteBatch_Reads(reads[v], targetU)
+        || SpriteBatch_Reads(reads[u], targetV);
+}
+
+/**
+ * Order the frame's views & group them into render passes, see
+ * `TinyDraw_EndFrame`, then pick the load & store operation of each pass.
+ *
+ * Of the views whose dependencies are drawn, one continuing the current pass
+ * goes first, then one whose target has no view left waiting on another
+ * target, so the views of a target gather into one pass once everything
+ * they sample is drawn.
+ */
+static void SpriteBatch_Build_Passes(void)
+{
+    static int slotTargets[SPRITE_TEXTURE_MAX];
+    for (int slot = 0; slot < batchTextureCount; slot++) {
+        slotTargets[slot] = -1;
+        for (int target = 0; target < batchTargetCount; target++) {
+            if (batchTargets[target] == batchTextures[slot]) {
+                slotTargets[slot] = target;
+                break;
+            }
+        }
+    }
+    
+    static Uint64 reads[SPRITE_VIEW_MAX][SPRITE_VIEW_MAX / 64];
+    for (int v = 0; v < batchViewCount; v++) {
+        const SpriteBatch_View* view = &batchViews[v];
+        SDL_memset(reads[v], 0, sizeof(reads[v]));
+        SpriteBatch_View_Reads(view, slotTargets, reads[v]);
+        if (view->source >= 0) {
+            SpriteBatch_View_Reads(&batchViews[view->source], slotTargets, reads[v]);
+        }
+    }
+    
+    // A later clear of the same target discards a view, unless something
+    // samples the target in between
+    for (int v = 0; v < batchViewCount; v++) {
+        SpriteBatch_View* view = &batchViews[v];
+        view->pass = -1;
+        for (int w = v + 1; w < batchViewCount; w++) {
+            if (SpriteBatch_Reads(reads[w], view->target)) {
+                break;
+            }
+            if (batchViews[w].target == view->target && batchViews[w].clear) {
+                view->skip = 1;
+                break;
+            }
+        }
+    }
+    
+    // Views each view still waits on, & views of each target still waiting
+    int waiting[SPRITE_VIEW_MAX];
+    int blocked[SPRITE_VIEW_MAX];
+    int lastPass[SPRITE_VIEW_MAX];
+    for (int target = 0; target < batchTargetCount; target++) {
+        blocked[target] = 0;
+        lastPass[target] = -1;
+    }
+    for (int v = 0; v < batchViewCount; v++) {
+        waiting[v] = 0;
+        if (batchViews[v].skip) {
+            continue;
+        }
+        
+        for (int u = 0; u < v; u++) {
+            if (!batchViews[u].skip && SpriteBatch_Depends(u, v, reads)) {
+                waiting[v]++;
+            }
+        }
+        if (waiting[v]) {
+            blocked[batchViews[v].target]++;
+        }
+    }
+    
+    batchPassCount = 0;
+    int current = -1;
+    for (;;) {
+        int next = -1;
+        for (int v = 0; v < batchViewCount; v++) {
+            const SpriteBatch_View* view = &batchViews[v];
+            if (view->skip || view->pass >= 0 || waiting[v]) {
+                continue;
+            }
+            
+            if (current >= 0 && view->target == batchPasses[current].target) {
+                next = v;
+                break;
+            }
+            if (next < 0 || (blocked[batchViews[next].target] && !blocked[view->target])) {
+                next = v;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        
+        SpriteBatch_View* view = &batchViews[next];
+        const int target = view->target;
+        if (current < 0 || batchPasses[current].target != target) {
+            current = batchPassCount++;
+            batchPasses[current] = (SpriteBatch_Pass) {
+                .target = target,
+                .storeOp = SDL_GPU_STOREOP_STORE,
+            };
+            if (view->clear) {
+                batchPasses[current].loadOp = SDL_GPU_LOADOP_CLEAR;
+            } else if (lastPass[target] < 0 && Transient_Find(batchTargets[target]) != NULL) {
+                // A transient target holds nothing before its first pass
+                batchPasses[current].loadOp = SDL_GPU_LOADOP_DONT_CARE;
+            } else {
+                batchPasses[current].loadOp = SDL_GPU_LOADOP_LOAD;
+            }
+            lastPass[target] = current;
+        }
+        
+        view->pass = current;
+        for (int i = 0; i < SPRITE_VIEW_MAX / 64; i++) {
+            batchPasses[current].reads[i] |= reads[next][i];
+        }
+        for (int w = next + 1; w < batchViewCount; w++) {
+            if (batchViews[w].skip || !SpriteBatch_Depends(next, w, reads)) {
+                continue;
+            }
+            if (--waiting[w] == 0) {
+                blocked[batchViews[w].target]--;
+            }
+        }
+    }
+    
+    // A transient target is dropped after the last pass sampling or loading it
+    for (int p = 0; p < batchPassCount; p++) {
+        SpriteBatch_Pass* pass = &batchPasses[p];
+        if (Transient_Find(batchTargets[pass->target]) == NULL) {
+            continue;
+        }
+        
+        pass->storeOp = SDL_GPU_STOREOP_DONT_CARE;
+        for (int q = p + 1; q < batchPassCount; q++) {
+            const SpriteBatch_Pass* later = &batchPasses[q];
+            if (
+                SpriteBatch_Reads(later->reads, pass->target)
+                || (later->target == pass->target && later->loadOp == SDL_GPU_LOADOP_LOAD)
+            ) {
+                pass->storeOp = SDL_GPU_STOREOP_STORE;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * A texture of `size` for the passes `firstPass` to `lastPass`, from the
+ * pool if one is free by then.
+ */
+static SDL_GPUTexture* Transient_Borrow(int2 size, int firstPass, int lastPass)
+{
+    for (int i = 0; i < transientPoolCount; i++) {
+        Transient_Texture* pooled = &transientPool[i];
+        if (pooled->size.x == size.x && pooled->size.y == size.y && pooled->busyUntil < firstPass) {
+            pooled->busyUntil = lastPass;
+            return pooled->texture;
+        }
+    }
+    
+    Transient_Texture* pool = SDL_realloc(transientPool, sizeof(Transient_Texture) * (transientPoolCount + 1));
+    if (pool == NULL) {
+        SDL_Log("Failed to grow transient target pool");
+        return NULL;
+    }
+    transientPool = pool;
+    
+    SDL_GPUTexture* texture = RenderTarget_Create_Texture(size.x, size.y);
+    if (texture == NULL) {
+        SDL_Log("Failed to create %dx%d transient target", size.x, size.y);
+        return NULL;
+    }
+    
+    transientPool[transientPoolCount++] = (Transient_Texture){
+        .texture = texture,
+        .size = size,
+        .busyUntil = lastPass,
+    };
+    
+    return texture;
+}
+
+/**
+ * Lend every transient target drawn into this frame a texture, shared with
+ * those of the same size whose passes don't overlap, & swap it in for the
+ * stand-in wherever the target is sampled.
+ */
+static void Transient_Assign(void)
+{
+    if (transientTargetCount == 0) {
+        return;
+    }
+    
+    for (int i = 0; i < transientTargetCount; i++) {
+        transientTargets[i].texture = NULL;
+        transientTargets[i].firstPass = -1;
+    }
+    for (int p = 0; p < batchPassCount; p++) {
+        for (int target = 0; target < batchTargetCount; target++) {
+            Transient_Target* transient = Transient_Find(batchTargets[target]);
+            if (
+                transient == NULL
+                || (target != batchPasses[p].target && !SpriteBatch_Reads(batchPasses[p].reads, target))
+            ) {
+                continue;
+            }
+            
+            if (transient->firstPass < 0) {
+                transient->firstPass = p;
+            }
+            transient->lastPass = p;
+        }
+    }
+    
+    // By first pass, so each texture goes to the next target to start
+    for (int i = 0; i < transientPoolCount; i++) {
+        transientPool[i].busyUntil = -1;
+    }
+    for (int p = 0; p < batchPassCount; p++) {
+        for (int i = 0; i < transientTargetCount; i++) {
+            Transient_Target* transient = &transientTargets[i];
+            if (transient->firstPass == p) {
+                transient->texture = Transient_Borrow(transient->size, p, transient->lastPass);
+            }
+        }
+    }
+    
+    // Sampled but never drawn into leaves `NULL`, & its draws are skipped
+    for (int slot = 0; slot < batchTextureCount; slot++) {
+        const Transient_Target* transient = Transient_Find(batchTextures[slot]);
+        if (transient != NULL) {
+            batchTextures[slot] = transient->texture;
+        }
+    }
+}
+
+/**
+ * Write sprites as quads into a new vertex buffer for `layer`, replacing the
+ * one it had, in the order of their `keys`.
+ */
+static int StaticLayer_Upload(
+    StaticLayer* layer,
+    const SpriteBatch_Store* store,
+    const Uint64* keys,
+    int spriteCount
+) {
+    if (layer->buffer != NULL) {
+        SDL_ReleaseGPUBuffer(device, layer->buffer);
+    }
+    
+    const Uint32 sizeInBytes = sizeof(Vertex) * 4 * spriteCount;
+    layer->buffer = SDL_CreateGPUBuffer(
+        device,
+        &(SDL_GPUBufferCreateInfo) {
+            .usageFlags = SDL_GPU_BUFFERUSAGE_VERTEX_BIT,
+            .sizeInBytes = sizeInBytes
+        }
+    );
+    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(
+        device,
+        &(SDL_GPUTransferBufferCreateInfo) {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .sizeInBytes = sizeInBytes
+        }
+    );
+    if (layer->buffer == NULL || transferBuffer == NULL) {
+        SDL_Log("Failed to create static layer buffer");
+        if (transferBuffer != NULL) {
+            SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        }
+        return 0;
+    }
+    SDL_SetGPUBufferName(
+        device,
+        layer->buffer,
+        "TinyDraw Static Layer"
+    );
+    
+    // One run of quads per layer, each at its layer's depth
+    const Uint64 layerMask = (Uint64) SPRITE_LAYER_MAX << SPRITE_KEY_LAYER_SHIFT;
+    Vertex* vertexData = SDL_MapGPUTransferBuffer(device, transferBuffer, SDL_FALSE);
+    for (int first = 0; first < spriteCount; ) {
+        int last = first + 1;
+        while (last < spriteCount && (keys[last] & layerMask) == (keys[first] & layerMask)) {
+            last++;
+        }
+        
+        spriteBatchWriteQuads(
+            &vertexData[first * 4],
+            store,
+            &keys[first],
+            last - first,
+            Sprite_Depth(SPRITE_KEY_FIELD(keys[first], SPRITE_KEY_LAYER_SHIFT, 12))
+        );
+        first = last;
+    }
+    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    
+    // Within a frame the upload rides along on its command buffer, ahead of
+    // the passes drawing the layer
+    SDL_GPUCommandBuffer* cmdbuf = frameCommandBuffer != NULL
+        ? frameCommandBuffer
+        : SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdbuf);
+    SDL_UploadToGPUBuffer(
+        copyPass,
+        &(SDL_GPUTransferBufferLocation) {
+            .transferBuffer = transferBuffer,
+            .offset = 0
+        },
+        &(SDL_GPUBufferRegion) {
+            .buffer = layer->buffer,
+            .offset = 0,
+            .size = sizeInBytes
+        },
+        SDL_FALSE
+    );
+    SDL_EndGPUCopyPass(copyPass);
+    frameStats.uploadBytes += sizeInBytes;
+    if (cmdbuf != frameCommandBuffer) {
+        SDL_SubmitGPU(cmdbuf);
+        frameStats.commandBuffers++;
+    }
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    
+    return 1;
+}
+
+/**
+ * Re-bake a chunk from its tiles. Its `StaticLayer` is kept, so a layer
+ * already staged this frame stays valid. A chunk that fails to bake stays
+ * dirty, so it's tried again the next time it's staged.
+ */
+static void Tilemap_Build_Chunk(Tilemap* tilemap, int chunkX, int chunkY)
+{
+    Tilemap_Chunk* chunk = &tilemap->chunks[chunkY * tilemap->chunkCount.x + chunkX];
+    
+    static SpriteBatch_Dest dest[TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE];
+    static SpriteBatch_Source source[TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE];
+    static Uint64 keys[TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE];
+    SpriteBatch_Store store = {
+        .dest = dest,
+        .source = source,
+    };
+    
+    const int columns = SDL_max(tilemap->tilesetSize.x / tilemap->tileSize.x, 1);
+    const float2 sourceSize = {
+        .x = (float) tilemap->tileSize.x / tilemap->tilesetSize.x,
+        .y = (float) tilemap->tileSize.y / tilemap->tilesetSize.y,
+    };
+    const int startX = chunkX * TILEMAP_CHUNK_SIZE;
+    const int startY = chunkY * TILEMAP_CHUNK_SIZE;
+    const int endX = SDL_min(startX + TILEMAP_CHUNK_SIZE, tilemap->width);
+    const int endY = SDL_min(startY + TILEMAP_CHUNK_SIZE, tilemap->height);
+    
+    int spriteCount = 0;
+    for (int y = startY; y < endY; y++) {
+        for (int x = startX; x < endX; x++) {
+            const int tile = tilemap->tiles[y * tilemap->width + x] - 1;
+            if (tile < 0) {
+                continue;
+            }
+            
+            SpriteBatch_Store_Set(
+                &store,
+                spriteCount,
+                (float2){ .x = (float) x * tilemap->tileSize.x, .y = (float) y * tilemap->tileSize.y },
+                (float2){ .x = (float) tilemap->tileSize.x, .y = (float) tilemap->tileSize.y },
+                (float2){ .x = (tile % columns) * sourceSize.x, .y = (tile / columns) * sourceSize.y },
+                sourceSize,
+                (Color){ 1, 1, 1, 1 }
+            );
+            keys[spriteCount] = spriteCount;
+            spriteCount++;
+        }
+    }
+    
+    if (spriteCount == 0) {
+        if (chunk->layer != NULL) {
+            chunk->layer->drawCount = 0;
+        }
+        chunk->dirty = 0;
+        return;
+    }
+    
+    if (chunk->layer == NULL) {
+        chunk->layer = SDL_calloc(1, sizeof(StaticLayer));
+        StaticLayer_Draw* draw = SDL_malloc(sizeof(StaticLayer_Draw));
+        if (chunk->layer == NULL || draw == NULL) {
+            SDL_Log("Failed to allocate tilemap chunk");
+            SDL_free(chunk->layer);
+            SDL_free(draw);
+            chunk->layer = NULL;
+            return;
+        }
+        chunk->layer->draws = draw;
+    }
+    
+    // A chunk is far below `SPRITE_COUNT_16BIT`, so one draw covers it
+    if (!StaticLayer_Upload(chunk->layer, &store, keys, spriteCount)) {
+        chunk->layer->drawCount = 0;
+        return;
+    }
+    chunk->layer->draws[0] = (StaticLayer_Draw) {
+        .pipeline = NULL,
+        .texture = tilemap->tileset,
+        .first = 0,
+        .count = spriteCount,
+    };
+    chunk->layer->drawCount = 1;
+    chunk->dirty = 0;
+}
+
+/**
+ * Shared by `TinyDraw_Init` & `TinyDraw_Init_Headless`.
+ */
+static int Init(char headless)
+{
+    // Still needed to load the Vulkan library, but without a display
+    if (headless) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
+        return 0;
+    }
+    
+    device = SDL_CreateGPUDevice(SDL_ShaderCross_GetShaderFormats(), SDL_TRUE, NULL);
+    if (device == NULL) {
+        SDL_Log("Failed to create GPU device");
+        return 0;
+    }
+    
+    if (!headless) {
+        window = SDL_CreateWindow(title, sizeWindow.x, sizeWindow.y, 0);
+        if (window == NULL) {
+            SDL_Log("Failed to create window: %s", SDL_GetError());
+            return 0;
+        }
+        
+        if (!SDL_ClaimGPUWindow(device, window)) {
+            SDL_Log("Failed to claim window");
+            return 0;
+        }
+    }
+    
+    basePath = SDL_GetBasePath();
+    frameStart = SDL_GetTicksNS();
+    
+    sampler = TinyDraw_Get_Sampler(TINYDRAW_FILTER_NEAREST, TINYDRAW_ADDRESS_CLAMP);
+    
+    if (!SpriteBatch_Reserve_Buffer(&vertexStream, sizeof(Vertex) * 4 * SPRITE_COUNT)) {
+        return 0;
+    }
+    
+    if (!SpriteBatch_Grow(SPRITE_COUNT)) {
+        return 0;
+    }
+    SpriteBatch_Select_Kernel();
+    
+    SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuf);
+    indexBuffer = SpriteBatch_Create_IndexBuffer(
+        copyPass,
+        SPRITE_COUNT_16BIT,
+        SDL_GPU_INDEXELEMENTSIZE_16BIT
+    );
+    SDL_EndGPUCopyPass(copyPass);
+    SDL_SubmitGPU(uploadCmdBuf);
+    frameStats.commandBuffers++;
+    if (indexBuffer == NULL) {
+        return 0;
+    }
+    
+    return 1;
+}
+
+// Public Methods
+
+int TinyDraw_Init(void)
+{
+    return Init(0);
+}
+
+int TinyDraw_Init_Headless(void)
+{
+    return Init(1);
+}
+
+void TinyDraw_Resize(int width, int height, char fullscreen)
+{
+    if (window == NULL) {
+        return;
+    }
+    
+    SDL_SetWindowFullscreen(window, fullscreen ? SDL_WINDOW_FULLSCREEN : 0);
+    
+    if (!fullscreen) {
+        SDL_SetWindowSize(window, width, height);
+        sizeWindow = (int2){ .x = width, .y = height };
+    }
+}
+
+SDL_GPUTexture* TinyDraw_Create_RenderTarget(int width, int height)
+{
+    // Without its size, it would be drawn into as if it were the screen
+    if (renderTargetCount == RENDER_TARGET_MAX) {
+        SDL_Log("Too many render targets, at most %d can be alive at once", RENDER_TARGET_MAX);
+        return NULL;
+    }
+    
+    SDL_GPUTexture* renderTarget = RenderTarget_Create_Texture(width, height);
+    if (renderTarget == NULL) {
+        return NULL;
+    }
+    
+    renderTargets[renderTargetCount++] = (RenderTarget_Info){
+        .texture = renderTarget,
+        .size = { .x = width, .y = height },
+    };
+    
+    return renderTarget;
+}
+
+void TinyDraw_Set_Resolution(int width, int height, char integerScale)
+{
+    if (width <= 0 || height <= 0) {
+        SDL_Log("Invalid resolution %dx%d", width, height);
+        return;
+    }
+    
+    sizeGame = (int2){ .x = width, .y = height };
+    sizeIntegerScale = integerScale;
+}
+
+SDL_GPUTexture* TinyDraw_Get_Transient_Target(int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        SDL_Log("Invalid transient target size %dx%d", width, height);
+        return NULL;
+    }
+    
+    if (transientTargetCount == TRANSIENT_TARGET_MAX) {
+        SDL_Log("Too many transient targets in one frame");
+        return NULL;
+    }
+    
+    Transient_Target* target = &transientTargets[transientTargetCount++];
+    *target = (Transient_Target){
+        .size = { .x = width, .y = height },
+    };
+    
+    return (SDL_GPUTexture*) target;
+}
+
+/**
+ * A pipeline taking `Vertex` input, blended or `opaque`.
+ */
+static SDL_GPUGraphicsPipeline* Pipeline_Create_Vertex(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader,
+    char opaque
+) {
+    return Pipeline_Create(
+        vertexShader,
+        fragmentShader,
+        (SDL_GPUVertexInputState){
+            .vertexBindingCount = 1,
+            .vertexBindings = (SDL_GPUVertexBinding[]){{
+                .binding = 0,
+                .inputRate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+                .instanceStepRate = 0,
+                .stride = sizeof(Vertex)
+            }},
+            .vertexAttributeCount = 3,
+            .vertexAttributes = (SDL_GPUVertexAttribute[]){
+                {
+                    .binding = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+                    .location = 0,
+                    .offset = 0,
+                },
+                {
+                    .binding = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+                    .location = 1,
+                    .offset = sizeof(float) * 3,
+                },
+                {
+                    .binding = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                    .location = 2,
+                    .offset = sizeof(float) * 5,
+                },
+            },
+        },
+        PIPELINE_MODE_VERTEX,
+        opaque
+    );
+}
+
+SDL_GPUGraphicsPipeline* TinyDraw_Create_Pipeline(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader
+)
+{
+    return Pipeline_Create_Vertex(vertexShader, fragmentShader, 0);
+}
+
+void TinyDraw_Set_Depth(char enabled)
+{
+    depthEnabled = enabled;
+}
+
+SDL_GPUGraphicsPipeline* TinyDraw_Create_Opaque_Pipeline(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader
+)
+{
+    if (!depthEnabled) {
+        SDL_Log("Opaque pipelines need TinyDraw_Set_Depth");
+        return NULL;
+    }
+    
+    return Pipeline_Create_Vertex(vertexShader, fragmentShader, 1);
+}
+
+SDL_GPUGraphicsPipeline* TinyDraw_Create_Instanced_Pipeline(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader
+)
+{
+    return Pipeline_Create(
+        vertexShader,
+        fragmentShader,
+        (SDL_GPUVertexInputState){
+            .vertexBindingCount = 1,
+            .vertexBindings = (SDL_GPUVertexBinding[]){{
+                .binding = 0,
+                .inputRate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
+                .instanceStepRate = 0,
+                .stride = sizeof(SpriteInstance)
+            }},
+            .vertexAttributeCount = 3,
+            .vertexAttributes = (SDL_GPUVertexAttribute[]){
+                {
+                    .binding = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                    .location = 0,
+                    .offset = 0,
+                },
+                {
+                    .binding = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_USHORT4_NORM,
+                    .location = 1,
+                    .offset = sizeof(float) * 4,
+                },
+                {
+                    .binding = 0,
+                    .format = SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM,
+                    .location = 2,
+                    .offset = sizeof(float) * 4 + sizeof(Uint16) * 4,
+                },
+            },
+        },
+        PIPELINE_MODE_INSTANCED,
+        0
+    );
+}
+
+SDL_GPUGraphicsPipeline* TinyDraw_Create_Storage_Pipeline(
+    SDL_GPUShader* vertexShader,
+    SDL_GPUShader* fragmentShader
+)
+{
+    return Pipeline_Create(
+        vertexShader,
+        fragmentShader,
+        (SDL_GPUVertexInputState){ 0 },
+        PIPELINE_MODE_STORAGE,
+        0
+    );
+}
+
+/**
+ * FNV-1a, continuing from `hash`.
+ */
+static Uint64 Shader_Hash(const void* data, size_t size, Uint64 hash)
+{
+    const Uint8* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+    
+    return hash;
+}
+
+/**
+ * Translate SPIR-V to what this backend takes, or `NULL` when it's done by
+ * `SDL_ShaderCross_CompileFromSPIRV` instead.
+ */
+static void* Shader_Translate(const SDL_GPUShaderCreateInfo* info, SDL_GPUShaderFormat format, size_t* size)
+{
+    const SDL_ShaderCross_ShaderStage stage = info->stage == SDL_GPU_SHADERSTAGE_VERTEX
+        ? SDL_SHADERCROSS_SHADERSTAGE_VERTEX
+        : SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+    
+    switch (format) {
+        case SDL_GPU_SHADERFORMAT_MSL: {
+            char* source = SDL_ShaderCross_TranspileMSLFromSPIRV(info->code, info->codeSize, info->entryPointName, stage);
+            *size = source != NULL ? SDL_strlen(source) + 1 : 0;
+            return source;
+        }
+        
+        case SDL_GPU_SHADERFORMAT_DXBC: {
+            return SDL_ShaderCross_CompileDXBCFromSPIRV(info->code, info->codeSize, info->entryPointName, stage, size);
+        }
+        
+        case SDL_GPU_SHADERFORMAT_DXIL: {
+            return SDL_ShaderCross_CompileDXILFromSPIRV(info->code, info->codeSize, info->entryPointName, stage, size);
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * The translation cached at `path`, or `NULL` without one. Truncated &
+ * corrupt files are removed, so the shader is translated again.
+ */
+static void* Shader_Cache_Load(const char* path, size_t* size)
+{
+    size_t fileSize = 0;
+    Uint8* file = SDL_LoadFile(path, &fileSize);
+    if (file == NULL) {
+        return NULL;
+    }
+    
+    Shader_Cache_Header header = { 0 };
+    if (fileSize >= sizeof(header)) {
+        SDL_memcpy(&header, file, sizeof(header));
+    }
+    if (
+        fileSize < sizeof(header)
+        || header.version != SHADER_CACHE_VERSION
+        || header.size != fileSize - sizeof(header)
+        || header.hash != Shader_Hash(file + sizeof(header), header.size, SHADER_HASH_SEED)
+    ) {
+        SDL_Log("Cached shader `%s` is corrupt, translating it again", path);
+        SDL_free(file);
+        SDL_RemovePath(path);
+        return NULL;
+    }
+    
+    SDL_memmove(file, file + sizeof(header), header.size);
+    *size = header.size;
+    
+    return file;
+}
+
+/**
+ * Cache a translation at `path`. Nothing is left behind if it fails, the
+ * shader is just translated again next time.
+ */
+static void Shader_Cache_Save(const char* path, const void* code, size_t size)
+{
+    SDL_IOStream* file = SDL_IOFromFile(path, "wb");
+    if (file == NULL) {
+        return;
+    }
+    
+    const Shader_Cache_Header header = {
+        .version = SHADER_CACHE_VERSION,
+        .size = size,
+        .hash = Shader_Hash(code, size, SHADER_HASH_SEED),
+    };
+    const char written = SDL_WriteIO(file, &header, sizeof(header)) == sizeof(header)
+        && SDL_WriteIO(file, code, size) == size;
+    if (!SDL_CloseIO(file) || !written) {
+        SDL_Log("Failed to cache shader `%s`", path);
+        SDL_RemovePath(path);
+    }
+}
+
+/**
+ * Create a shader from `code`, translated from `info` into `format`.
+ */
+static SDL_GPUShader* Shader_Create_Translated(
+    const SDL_GPUShaderCreateInfo* info,
+    SDL_GPUShaderFormat format,
+    const void* code,
+    size_t size
+) {
+    SDL_GPUShaderCreateInfo translated = *info;
+    translated.code = code;
+    translated.codeSize = size;
+    translated.format = format;
+    // SPIRV-Cross renames `main`, which is reserved in Metal
+    if (format == SDL_GPU_SHADERFORMAT_MSL) {
+        translated.entryPointName = "main0";
+    }
+    
+    return SDL_CreateGPUShader(device, &translated);
+}
+
+/**
+ * What this backend's shaders are translated to & cached as, or
+ * `SDL_GPU_SHADERFORMAT_INVALID` when it takes SPIR-V or can't be cached.
+ */
+static SDL_GPUShaderFormat Shader_Cache_Format(void)
+{
+    switch (SDL_GetGPUDriver(device)) {
+        case SDL_GPU_DRIVER_METAL: return SDL_GPU_SHADERFORMAT_MSL;
+        case SDL_GPU_DRIVER_D3D11: return SDL_GPU_SHADERFORMAT_DXBC;
+        case SDL_GPU_DRIVER_D3D12: return SDL_GPU_SHADERFORMAT_DXIL;
+        default: return SDL_GPU_SHADERFORMAT_INVALID;
+    }
+}
+
+/**
+ * Where the translation of `info` into `format` is cached.
+ *
+ * @return  char    0 if there's nowhere to cache it
+ */
+static char Shader_Cache_Path(
+    const SDL_GPUShaderCreateInfo* info,
+    SDL_GPUShaderFormat format,
+    char* path,
+    size_t pathSize
+) {
+    if (cachePath == NULL) {
+        cachePath = SDL_GetPrefPath("TinyDraw", "shaders");
+    }
+    if (cachePath == NULL) {
+        return 0;
+    }
+    
+    // The stage is part of the key, as the same SPIR-V may hold both
+    Uint64 hash = Shader_Hash(info->code, info->codeSize, SHADER_HASH_SEED);
+    hash = Shader_Hash(&format, sizeof(format), hash);
+    hash = Shader_Hash(&info->stage, sizeof(info->stage), hash);
+    const Uint32 version = SHADER_CACHE_VERSION;
+    hash = Shader_Hash(&version, sizeof(version), hash);
+    SDL_snprintf(path, pathSize, "%s%016llx.shader", cachePath, (unsigned long long) hash);
+    
+    return 1;
+}
+
+/**
+ * Create a shader from its translation cached on disk, translating & caching
+ * it first if needed, or if the cached one doesn't load. Falls back to
+ * `SDL_ShaderCross_CompileFromSPIRV` for backends without a cached format.
+ */
+static SDL_GPUShader* Shader_Load_Cached(const SDL_GPUShaderCreateInfo* info)
+{
+    const SDL_GPUShaderFormat format = Shader_Cache_Format();
+    if (format == SDL_GPU_SHADERFORMAT_INVALID) {
+        return SDL_ShaderCross_CompileFromSPIRV(device, info, SDL_FALSE);
+    }
+    
+    char path[512];
+    const char cached = Shader_Cache_Path(info, format, path, sizeof(path));
+    size_t size = 0;
+    void* code = cached ? Shader_Cache_Load(path, &size) : NULL;
+    if (code != NULL) {
+        SDL_GPUShader* shader = Shader_Create_Translated(info, format, code, size);
+        SDL_free(code);
+        if (shader != NULL) {
+            return shader;
+        }
+        
+        // e.g. made for another driver, so translate it again
+        SDL_Log("Failed to create cached shader `%s`: %s", path, SDL_GetError());
+        SDL_RemovePath(path);
+    }
+    
+    code = Shader_Translate(info, format, &size);
+    if (code == NULL) {
+        SDL_Log("Failed to translate shader: %s", SDL_GetError());
+        return NULL;
+    }
+    
+    // Without a cache, the shader still loads, just translated every time
+    if (cached) {
+        Shader_Cache_Save(path, code, size);
+    }
+    SDL_GPUShader* shader = Shader_Create_Translated(info, format, code, size);
+    SDL_free(code);
+    
+    return shader;
+}
+
+SDL_GPUShader* TinyDraw_Load_Shader(
+    const char* fileName,
+    Uint32 samplerCount,
+    Uint32 uniformBufferCount,
+    Uint32 storageBufferCount,
+    Uint32 storageTextureCount,
+    SDL_GPUShaderStage stage
+)
+{
+    SDL_snprintf(
+        fullPath,
+        sizeof(fullPath),
+        "%sContent/shaders/%s.spv",
+        basePath,
+        fileName
+    );
+    
+    size_t codeSize;
+    void* code = SDL_LoadFile(fullPath, &codeSize);
+    if (code == NULL) {
+        SDL_Log("Failed to load shader from disk! %s", fullPath);
+        return NULL;
+    }
+    
+    SDL_GPUShader* shader;
+    SDL_GPUShaderCreateInfo shaderInfo = {
+        .code = code,
+        .codeSize = codeSize,
+        .entryPointName = "main",
+        .format = SDL_GPU_SHADERFORMAT_SPIRV,
+        .stage = stage,
+        .samplerCount = samplerCount,
+        .uniformBufferCount = uniformBufferCount,
+        .storageBufferCount = storageBufferCount,
+        .storageTextureCount = storageTextureCount
+    };
+    
+    if (SDL_GetGPUDriver(device) == SDL_GPU_DRIVER_VULKAN) {
+        shader = SDL_CreateGPUShader(device, &shaderInfo);
+    } else {
+        shader = Shader_Load_Cached(&shaderInfo);
+    }
+    
+    if (shader == NULL) {
+        SDL_Log("Failed to create shader!");
+        SDL_free(code);
+        return NULL;
+    }
+    
+    SDL_free(code);
+    
+    return shader;
+}
+
+/**
+ * Create a texture & upload a whole mip chain, stored largest level first,
+ * with its own command buffer.
+ */
+static SDL_GPUTexture* Texture_Upload(
+    SDL_GPUTextureFormat format,
+    Uint32 width,
+    Uint32 height,
+    Uint32 levelCount,
+    const void* data
+) {
+    if (!SDL_SupportsGPUTextureFormat(device, format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT)) {
+        SDL_Log("Texture format %d isn't supported by this GPU", (int) format);
+        return NULL;
+    }
+    
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture(device, &(SDL_GPUTextureCreateInfo){
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = format,
+        .width = width,
+        .height = height,
+        .layerCountOrDepth = 1,
+        .levelCount = levelCount,
+        .usageFlags = SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT
+    });
+    if (texture == NULL) {
+        SDL_Log("Failed to create texture");
+        return NULL;
+    }
+    
+    const Uint64 size = Texture_Size(format, width, height, levelCount);
+    SDL_GPUTransferBuffer* textureTransferBuffer = SDL_CreateGPUTransferBuffer(
+        device,
+        &(SDL_GPUTransferBufferCreateInfo) {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .sizeInBytes = (Uint32) size
+        }
+    );
+    if (textureTransferBuffer == NULL) {
+        SDL_Log("Failed to create texture transfer buffer");
+        SDL_ReleaseGPUTexture(device, texture);
+        return NULL;
+    }
+    Uint8* textureTransferPtr = SDL_MapGPUTransferBuffer(
+        device,
+        textureTransferBuffer,
+        SDL_FALSE
+    );
+    SDL_memcpy(textureTransferPtr, data, size);
+    SDL_UnmapGPUTransferBuffer(device, textureTransferBuffer);
+    
+    SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuf);
+    Uint64 offset = 0;
+    for (Uint32 level = 0; level < levelCount; level++) {
+        const Uint32 w = SDL_max(width >> level, 1);
+        const Uint32 h = SDL_max(height >> level, 1);
+        SDL_UploadToGPUTexture(
+            copyPass,
+            &(SDL_GPUTextureTransferInfo) {
+                .transferBuffer = textureTransferBuffer,
+                .offset = (Uint32) offset,
+            },
+            &(SDL_GPUTextureRegion){
+                .texture = texture,
+                .mipLevel = level,
+                .w = w,
+                .h = h,
+                .d = 1
+            },
+            SDL_FALSE
+        );
+        offset += Texture_Level_Size(format, w, h);
+    }
+    SDL_EndGPUCopyPass(copyPass);
+    SDL_SubmitGPU(uploadCmdBuf);
+    SDL_ReleaseGPUTransferBuffer(device, textureTransferBuffer);
+    frameStats.uploadBytes += size;
+    frameStats.commandBuffers++;
+    
+    return texture;
+}
+
+// DDS files: "DDS ", a 124 byte header & a 20 byte DX10 header if the pixel
+// format's FourCC is "DX10", then every mip level back to back
+#define DDS_MAGIC 0x20534444
+#define DDS_FOURCC_DXT1 0x31545844
+#define DDS_FOURCC_DXT5 0x35545844
+#define DDS_FOURCC_DX10 0x30315844
+#define DDS_DXGI_BC1_UNORM 71
+#define DDS_DXGI_BC1_UNORM_SRGB 72
+#define DDS_DXGI_BC3_UNORM 77
+#define DDS_DXGI_BC3_UNORM_SRGB 78
+#define DDS_DXGI_BC7_UNORM 98
+#define DDS_DXGI_BC7_UNORM_SRGB 99
+
+/**
+ * Load a BC1, BC3 or BC7 texture from a DDS file.
+ */
+static SDL_GPUTexture* Texture_Load_DDS(const char* path, int* width, int* height)
+{
+    size_t fileSize = 0;
+    Uint8* file = SDL_LoadFile(path, &fileSize);
+    if (file == NULL) {
+        SDL_Log("Failed to load image `%s`\n", path);
+        return NULL;
+    }
+    
+    // Header fields as 32-bit words, after the magic
+    Uint32 header[31] = { 0 };
+    Uint32 dx10[5] = { 0 };
+    size_t dataOffset = 4 + sizeof(header);
+    Uint32 magic = 0;
+    if (fileSize >= dataOffset) {
+        SDL_memcpy(&magic, file, 4);
+        SDL_memcpy(header, &file[4], sizeof(header));
+    }
+    
+    // Words 3 & 2 are the size, 6 the mip count & 20 the pixel format's FourCC
+    const Uint32 fourCC = header[20];
+    if (fourCC == DDS_FOURCC_DX10 && fileSize >= dataOffset + sizeof(dx10)) {
+        SDL_memcpy(dx10, &file[dataOffset], sizeof(dx10));
+        dataOffset += sizeof(dx10);
+    }
+    
+    SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_INVALID;
+    if (fourCC == DDS_FOURCC_DXT1 || dx10[0] == DDS_DXGI_BC1_UNORM || dx10[0] == DDS_DXGI_BC1_UNORM_SRGB) {
+        format = SDL_GPU_TEXTUREFORMAT_BC1_UNORM;
+    } else if (fourCC == DDS_FOURCC_DXT5 || dx10[0] == DDS_DXGI_BC3_UNORM || dx10[0] == DDS_DXGI_BC3_UNORM_SRGB) {
+        format = SDL_GPU_TEXTUREFORMAT_BC3_UNORM;
+    } else if (dx10[0] == DDS_DXGI_BC7_UNORM || dx10[0] == DDS_DXGI_BC7_UNORM_SRGB) {
+        format = SDL_GPU_TEXTUREFORMAT_BC7_UNORM;
+    }
+    
+    const Uint32 w = header[3];
+    const Uint32 h = header[2];
+    const Uint32 levelCount = SDL_max(header[6], 1);
+    if (
+        magic != DDS_MAGIC
+        || format == SDL_GPU_TEXTUREFORMAT_INVALID
+        || w == 0 || w > 16384
+        || h == 0 || h > 16384
+        || levelCount > 16
+        || Texture_Size(format, w, h, levelCount) > fileSize - dataOffset
+    ) {
+        SDL_Log("`%s` isn't a BC1, BC3 or BC7 DDS file", path);
+        SDL_free(file);
+        return NULL;
+    }
+    
+    SDL_GPUTexture* texture = Texture_Upload(format, w, h, levelCount, &file[dataOffset]);
+    SDL_free(file);
+    
+    if (texture != NULL && width != NULL) {
+        *width = w;
+    }
+    
+    if (texture != NULL && height != NULL) {
+        *height = h;
+    }
+    
+    return texture;
+}
+
+SDL_GPUTexture* TinyDraw_Load_Texture(
+    const char* fileName,
+    int* width,
+    int* height
+)
+{
+    SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/sprites/%s", basePath, fileName);
+    const size_t length = SDL_strlen(fullPath);
+    if (length > 4 && SDL_strcasecmp(&fullPath[length - 4], ".dds") == 0) {
+        return Texture_Load_DDS(fullPath, width, height);
+    }
+    
+    int w, h;
+    Uint32 levelCount;
+    Uint8* pixels = Texture_Decode(fullPath, &w, &h, &levelCount);
+    if (pixels == NULL) {
+        return NULL;
+    }
+    
+    if (width != NULL) {
+        *width = w;
+    }
+    
+    if (height != NULL) {
+        *height = h;
+    }
+    
+    SDL_GPUTexture* texture = Texture_Upload(SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, w, h, levelCount, pixels);
+    SDL_free(pixels);
+    
+    return texture;
+}
+
+TextureLoad* TinyDraw_Load_Texture_Async(const char* fileName)
+{
+    if (!TextureLoad_Start()) {
+        return NULL;
+    }
+    
+    TextureLoad* load = SDL_calloc(1, sizeof(TextureLoad));
+    if (load == NULL) {
+        SDL_Log("Failed to allocate texture load");
+        return NULL;
+    }
+    SDL_snprintf(load->path, sizeof(load->path), "%sContent/sprites/%s", basePath, fileName);
+    load->state = TINYDRAW_LOAD_PENDING;
+    
+    SDL_LockMutex(textureLoadMutex);
+    TextureLoad_Push(&textureLoadQueue, &textureLoadQueueTail, load);
+    SDL_SignalCondition(textureLoadQueued);
+    SDL_UnlockMutex(textureLoadMutex);
+    
+    return load;
+}
+
+int TinyDraw_Poll_Texture_Load(TextureLoad* load)
+{
+    if (load == NULL) {
+        return TINYDRAW_LOAD_FAILED;
+    }
+    
+    SDL_LockMutex(textureLoadMutex);
+    const int state = load->state;
+    SDL_UnlockMutex(textureLoadMutex);
+    
+    return state == TEXTURE_LOAD_DECODED ? TINYDRAW_LOAD_PENDING : state;
+}
+
+SDL_GPUTexture* TinyDraw_Finish_Texture_Load(
+    TextureLoad* load,
+    int* width,
+    int* height
+)
+{
+    if (load == NULL) {
+        return NULL;
+    }
+    
+    SDL_LockMutex(textureLoadMutex);
+    while (load->state == TINYDRAW_LOAD_PENDING) {
+        SDL_WaitCondition(textureLoadDecoded, textureLoadMutex);
+    }
+    const int state = load->state;
+    if (state == TEXTURE_LOAD_DECODED) {
+        TextureLoad* previous = NULL;
+        for (TextureLoad** link = &textureLoadDecodedList; *link != NULL; link = &(*link)->next) {
+            if (*link == load) {
+                *link = load->next;
+                if (textureLoadDecodedTail == load) {
+                    textureLoadDecodedTail = previous;
+                }
+                break;
+            }
+            previous = *link;
+        }
+        load->next = NULL;
+    }
+    SDL_UnlockMutex(textureLoadMutex);
+    
+    if (state == TEXTURE_LOAD_DECODED) {
+        SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(device);
+        TextureLoad_Upload(uploadCmdBuf, load);
+        SDL_SubmitGPU(uploadCmdBuf);
+        frameStats.commandBuffers++;
+    }
+    
+    SDL_GPUTexture* texture = load->texture;
+    if (texture != NULL && width != NULL) {
+        *width = load->width;
+    }
+    if (texture != NULL && height != NULL) {
+        *height = load->height;
+    }
+    SDL_free(load);
+    
+    return texture;
+}
+
+/**
+ * Height of the skyline under a `width` wide rect starting at node `index`,
+ * or -1 if a `width` x `height` rect doesn't fit there.
+ */
+static int Atlas_Skyline_Fit(const Atlas_Page* page, int pageSize, int index, int width, int height)
+{
+    if (page->skyline[index].x + width > pageSize) {
+        return -1;
+    }
+    
+    int y = 0;
+    int remaining = width;
+    for (int i = index; remaining > 0; i++) {
+        y = SDL_max(y, page->skyline[i].y);
+        if (y + height > pageSize) {
+            return -1;
+        }
+        remaining -= page->skyline[i].width;
+    }
+    
+    return y;
+}
+
+/**
+ * Raise the skyline under a rect placed at node `index`.
+ */
+static void Atlas_Skyline_Add(Atlas_Page* page, int index, int y, int width, int height)
+{
+    Atlas_Node* skyline = page->skyline;
+    SDL_memmove(&skyline[index + 1], &skyline[index], sizeof(Atlas_Node) * (page->nodeCount - index));
+    skyline[index].y = y + height;
+    skyline[index].width = width;
+    page->nodeCount++;
+    
+    // Cut the nodes the rect now covers
+    const int right = skyline[index].x + width;
+    int next = index + 1;
+    while (next < page->nodeCount && skyline[next].x < right) {
+        const int shrink = right - skyline[next].x;
+        if (skyline[next].width > shrink) {
+            skyline[next].x += shrink;
+            skyline[next].width -= shrink;
+            break;
+        }
+        SDL_memmove(&skyline[next], &skyline[next + 1], sizeof(Atlas_Node) * (page->nodeCount - next - 1));
+        page->nodeCount--;
+    }
+    
+    for (int i = 0; i + 1 < page->nodeCount;) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            SDL_memmove(&skyline[i + 1], &skyline[i + 2], sizeof(Atlas_Node) * (page->nodeCount - i - 2));
+            page->nodeCount--;
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * Find the lowest spot for a rect on a page, leftmost on ties.
+ *
+ * @return  int the node to place it at, -1 if the page is full
+ */
+static int Atlas_Page_Find(const Atlas_Page* page, int pageSize, int width, int height, int* y)
+{
+    int best = -1;
+    for (int i = 0; i < page->nodeCount; i++) {
+        const int fit = Atlas_Skyline_Fit(page, pageSize, i, width, height);
+        if (fit >= 0 && (best < 0 || fit < *y)) {
+            best = i;
+            *y = fit;
+        }
+    }
+    
+    return best;
+}
+
+static Atlas_Page* Atlas_Open_Page(Atlas* atlas)
+{
+    if (atlas->pageCount == ATLAS_PAGE_MAX) {
+        SDL_Log("Atlas has no pages left");
+        return NULL;
+    }
+    
+    Atlas_Page* page = &atlas->pages[atlas->pageCount];
+    const int size = atlas->pageSize;
+    page->pixels = SDL_calloc((size_t) size * size, 4);
+    // Every node is at least a pixel wide
+    page->skyline = SDL_malloc(sizeof(Atlas_Node) * (size + 1));
+    page->texture = SDL_CreateGPUTexture(device, &(SDL_GPUTextureCreateInfo){
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        .width = size,
+        .height = size,
+        .layerCountOrDepth = 1,
+        .levelCount = 1,
+        .usageFlags = SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT
+    });
+    if (page->pixels == NULL || page->skyline == NULL || page->texture == NULL) {
+        SDL_Log("Failed to create atlas page");
+        SDL_free(page->pixels);
+        SDL_free(page->skyline);
+        if (page->texture != NULL) {
+            SDL_ReleaseGPUTexture(device, page->texture);
+        }
+        *page = (Atlas_Page){ 0 };
+        return NULL;
+    }
+    
+    page->skyline[0] = (Atlas_Node){ .x = 0, .y = 0, .width = size };
+    page->nodeCount = 1;
+    // The whole page, so the texture never holds garbage
+    page->dirtyTop = 0;
+    page->dirtyBottom = size;
+    atlas->pageCount++;
+    
+    return page;
+}
+
+Atlas* TinyDraw_Create_Atlas(int pageSize, int padding)
+{
+    if (pageSize <= 0 || padding < 0 || padding * 2 >= pageSize) {
+        SDL_Log("Invalid atlas page size or padding");
+        return NULL;
+    }
+    
+    Atlas* atlas = SDL_calloc(1, sizeof(Atlas));
+    if (atlas == NULL) {
+        SDL_Log("Failed to allocate atlas");
+        return NULL;
+    }
+    atlas->pageSize = pageSize;
+    atlas->padding = padding;
+    
+    return atlas;
+}
+
+int TinyDraw_Add_Atlas_Image(Atlas* atlas, const char* fileName, AtlasRegion* region)
+{
+    SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/sprites/%s", basePath, fileName);
+    int w, h, comp;
+    unsigned char* pixels = stbi_load(fullPath, &w, &h, &comp, 4);
+    if (pixels == NULL) {
+        SDL_Log("Failed to load image `%s`\n", fullPath);
+        return 0;
+    }
+    
+    const int added = TinyDraw_Add_Atlas_Pixels(atlas, pixels, w, h, region);
+    stbi_image_free(pixels);
+    
+    return added;
+}
+
+int TinyDraw_Add_Atlas_Pixels(
+    Atlas* atlas,
+    const Uint8* pixels,
+    int width,
+    int height,
+    AtlasRegion* region
+)
+{
+    const int size = atlas->pageSize;
+    const int padding = atlas->padding;
+    const int paddedWidth = width + padding * 2;
+    const int paddedHeight = height + padding * 2;
+    if (width <= 0 || height <= 0 || paddedWidth > size || paddedHeight > size) {
+        SDL_Log("Image of %dx%d doesn't fit an atlas page", width, height);
+        return 0;
+    }
+    
+    Atlas_Page* page = NULL;
+    int node = -1;
+    int y = 0;
+    for (int p = 0; p < atlas->pageCount && node < 0; p++) {
+        page = &atlas->pages[p];
+        node = Atlas_Page_Find(page, size, paddedWidth, paddedHeight, &y);
+    }
+    if (node < 0) {
+        page = Atlas_Open_Page(atlas);
+        if (page == NULL) {
+            return 0;
+        }
+        node = 0;
+        y = 0;
+    }
+    
+    const int x = page->skyline[node].x;
+    Atlas_Skyline_Add(page, node, y, paddedWidth, paddedHeight);
+    
+    // Copy the image, repeating its outermost pixels into the padding
+    const size_t rowBytes = (size_t) width * 4;
+    for (int row = 0; row < paddedHeight; row++) {
+        const int sourceRow = SDL_clamp(row - padding, 0, height - 1);
+        const Uint8* source = &pixels[sourceRow * rowBytes];
+        Uint8* dest = &page->pixels[((size_t) (y + row) * size + x) * 4];
+        for (int column = 0; column < padding; column++) {
+            SDL_memcpy(&dest[column * 4], source, 4);
+            SDL_memcpy(&dest[(padding + width + column) * 4], &source[rowBytes - 4], 4);
+        }
+        SDL_memcpy(&dest[padding * 4], source, rowBytes);
+    }
+    
+    if (page->dirtyTop >= page->dirtyBottom) {
+        page->dirtyTop = y;
+        page->dirtyBottom = y + paddedHeight;
+    } else {
+        page->dirtyTop = SDL_min(page->dirtyTop, y);
+        page->dirtyBottom = SDL_max(page->dirtyBottom, y + paddedHeight);
+    }
+    
+    if (region != NULL) {
+        *region = (AtlasRegion){
+            .texture = page->texture,
+            .sourcePos = {
+                .x = (float) (x + padding) / size,
+                .y = (float) (y + padding) / size,
+            },
+            .sourceSize = {
+                .x = (float) width / size,
+                .y = (float) height / size,
+            },
+            .size = { .x = width, .y = height },
+        };
+    }
+    
+    return 1;
+}
+
+void TinyDraw_Upload_Atlas(Atlas* atlas)
+{
+    const Uint32 rowBytes = atlas->pageSize * 4;
+    Uint32 size = 0;
+    for (int p = 0; p < atlas->pageCount; p++) {
+        const Atlas_Page* page = &atlas->pages[p];
+        if (page->dirtyTop < page->dirtyBottom) {
+            size += (page->dirtyBottom - page->dirtyTop) * rowBytes;
+        }
+    }
+    if (size == 0) {
+        return;
+    }
+    
+    // Dirty rows are whole rows of the page, so each page is one memcpy
+    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(
+        device,
+        &(SDL_GPUTransferBufferCreateInfo) {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .sizeInBytes = size
+        }
+    );
+    if (transferBuffer == NULL) {
+        SDL_Log("Failed to create atlas transfer buffer");
+        return;
+    }
+    
+    Uint8* transferData = SDL_MapGPUTransferBuffer(device, transferBuffer, SDL_FALSE);
+    Uint32 offset = 0;
+    for (int p = 0; p < atlas->pageCount; p++) {
+        const Atlas_Page* page = &atlas->pages[p];
+        if (page->dirtyTop < page->dirtyBottom) {
+            const Uint32 pageBytes = (page->dirtyBottom - page->dirtyTop) * rowBytes;
+            SDL_memcpy(&transferData[offset], &page->pixels[page->dirtyTop * rowBytes], pageBytes);
+            offset += pageBytes;
+        }
+    }
+    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    
+    SDL_GPUCommandBuffer* cmdbuf = frameCommandBuffer != NULL
+        ? frameCommandBuffer
+        : SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdbuf);
+    offset = 0;
+    for (int p = 0; p < atlas->pageCount; p++) {
+        Atlas_Page* page = &atlas->pages[p];
+        if (page->dirtyTop >= page->dirtyBottom) {
+            continue;
+        }
+        
+        SDL_UploadToGPUTexture(
+            copyPass,
+            &(SDL_GPUTextureTransferInfo) {
+                .transferBuffer = transferBuffer,
+                .offset = offset,
+            },
+            &(SDL_GPUTextureRegion){
+                .texture = page->texture,
+                .y = page->dirtyTop,
+                .w = atlas->pageSize,
+                .h = page->dirtyBottom - page->dirtyTop,
+                .d = 1
+            },
+            SDL_FALSE
+        );
+        offset += (page->dirtyBottom - page->dirtyTop) * rowBytes;
+        page->dirtyTop = page->dirtyBottom = 0;
+    }
+    SDL_EndGPUCopyPass(copyPass);
+    frameStats.uploadBytes += offset;
+    if (cmdbuf != frameCommandBuffer) {
+        SDL_SubmitGPU(cmdbuf);
+        frameStats.commandBuffers++;
+    }
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+}
+
+void TinyDraw_Destroy_Atlas(Atlas* atlas)
+{
+    if (atlas == NULL) {
+        return;
+    }
+    
+    for (int p = 0; p < atlas->pageCount; p++) {
+        SDL_ReleaseGPUTexture(device, atlas->pages[p].texture);
+        SDL_free(atlas->pages[p].pixels);
+        SDL_free(atlas->pages[p].skyline);
+    }
+    SDL_free(atlas);
+}
+
+/**
+ * GPU format of a texture in a pack, `SDL_GPU_TEXTUREFORMAT_INVALID` if
+ * unknown.
+ */
+static SDL_GPUTextureFormat Pack_Format(Uint32 format)
+{
+    switch (format) {
+        case TINYDRAW_PACK_FORMAT_RGBA8: return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        case TINYDRAW_PACK_FORMAT_BC1: return SDL_GPU_TEXTUREFORMAT_BC1_UNORM;
+        case TINYDRAW_PACK_FORMAT_BC3: return SDL_GPU_TEXTUREFORMAT_BC3_UNORM;
+        case TINYDRAW_PACK_FORMAT_BC7: return SDL_GPU_TEXTUREFORMAT_BC7_UNORM;
+        default: return SDL_GPU_TEXTUREFORMAT_INVALID;
+    }
+}
+
+/**
+ * Bytes of a texture's mip chain, or 0 if it isn't valid.
+ */
+static Uint64 Pack_Texture_Size(const PackTexture* texture)
+{
+    if (
+        Pack_Format(texture->format) == SDL_GPU_TEXTUREFORMAT_INVALID
+        || texture->width == 0
+        || texture->width > 16384
+        || texture->height == 0
+        || texture->height > 16384
+        || texture->levelCount == 0
+        || texture->levelCount > 16
+    ) {
+        return 0;
+    }
+    
+    return Texture_Size(
+        Pack_Format(texture->format),
+        texture->width,
+        texture->height,
+        texture->levelCount
+    );
+}
+
+TexturePack* TinyDraw_Load_Pack(const char* fileName)
+{
+    SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/%s", basePath, fileName);
+    SDL_IOStream* file = SDL_IOFromFile(fullPath, "rb");
+    if (file == NULL) {
+        SDL_Log("Failed to open texture pack `%s`", fullPath);
+        return NULL;
+    }
+    
+    const Sint64 fileSize = SDL_GetIOSize(file);
+    PackHeader header;
+    if (
+        SDL_ReadIO(file, &header, sizeof(header)) != sizeof(header)
+        || header.magic != TINYDRAW_PACK_MAGIC
+        || header.version != TINYDRAW_PACK_VERSION
+        || header.textureCount > (Uint64) fileSize / sizeof(PackTexture)
+        || header.regionCount > (Uint64) fileSize / sizeof(PackRegion)
+        || header.dataOffset > (Uint64) fileSize
+        || header.dataSize > (Uint64) fileSize - header.dataOffset
+        || header.dataSize > SDL_MAX_UINT32
+    ) {
+        SDL_Log("`%s` isn't a texture pack of version %d", fullPath, TINYDRAW_PACK_VERSION);
+        SDL_CloseIO(file);
+        return NULL;
+    }
+    
+    TexturePack* pack = SDL_calloc(1, sizeof(TexturePack));
+    PackTexture* textures = SDL_malloc(sizeof(PackTexture) * (header.textureCount + 1));
+    if (pack != NULL) {
+        pack->textures = SDL_calloc(header.textureCount + 1, sizeof(SDL_GPUTexture*));
+        pack->regions = SDL_malloc(sizeof(PackRegion) * (header.regionCount + 1));
+    }
+    if (pack == NULL || textures == NULL || pack->textures == NULL || pack->regions == NULL) {
+        SDL_Log("Failed to allocate texture pack");
+        SDL_free(textures);
+        TinyDraw_Unload_Pack(pack);
+        SDL_CloseIO(file);
+        return NULL;
+    }
+    
+    const size_t indexSize = sizeof(PackTexture) * header.textureCount;
+    const size_t regionSize = sizeof(PackRegion) * header.regionCount;
+    char valid = SDL_ReadIO(file, textures, indexSize) == indexSize
+        && SDL_ReadIO(file, pack->regions, regionSize) == regionSize;
+    for (Uint32 i = 0; valid && i < header.textureCount; i++) {
+        const Uint64 size = Pack_Texture_Size(&textures[i]);
+        valid = size != 0
+            && size == textures[i].size
+            && textures[i].offset >= header.dataOffset
+            && textures[i].offset + size <= header.dataOffset + header.dataSize;
+    }
+    for (Uint32 i = 0; valid && i < header.regionCount; i++) {
+        valid = pack->regions[i].texture < header.textureCount;
+        pack->regions[i].name[TINYDRAW_PACK_NAME_LENGTH - 1] = '\0';
+    }
+    if (!valid) {
+        SDL_Log("Texture pack `%s` is corrupt", fullPath);
+        SDL_free(textures);
+        TinyDraw_Unload_Pack(pack);
+        SDL_CloseIO(file);
+        return NULL;
+    }
+    pack->regionCount = header.regionCount;
+    
+    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(
+        device,
+        &(SDL_GPUTransferBufferCreateInfo) {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .sizeInBytes = (Uint32) SDL_max(header.dataSize, 1)
+        }
+    );
+    Uint8* transferData = transferBuffer != NULL
+        ? SDL_MapGPUTransferBuffer(device, transferBuffer, SDL_FALSE)
+        : NULL;
+    valid = transferData != NULL
+        && SDL_SeekIO(file, header.dataOffset, SDL_IO_SEEK_SET) == (Sint64) header.dataOffset
+        && SDL_ReadIO(file, transferData, header.dataSize) == header.dataSize;
+    SDL_CloseIO(file);
+    if (transferData != NULL) {
+        SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    }
+    if (!valid) {
+        SDL_Log("Failed to read texture pack `%s`", fullPath);
+        if (transferBuffer != NULL) {
+            SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        }
+        SDL_free(textures);
+        TinyDraw_Unload_Pack(pack);
+        return NULL;
+    }
+    
+    SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuf);
+    for (Uint32 i = 0; i < header.textureCount; i++) {
+        const PackTexture* info = &textures[i];
+        const SDL_GPUTextureFormat format = Pack_Format(info->format);
+        if (!SDL_SupportsGPUTextureFormat(device, format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT)) {
+            SDL_Log("Texture %d of pack `%s` has a format this GPU doesn't support", (int) i, fullPath);
+            continue;
+        }
+        
+        SDL_GPUTexture* texture = SDL_CreateGPUTexture(device, &(SDL_GPUTextureCreateInfo){
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = format,
+            .width = info->width,
+            .height = info->height,
+            .layerCountOrDepth = 1,
+            .levelCount = info->levelCount,
+            .usageFlags = SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT
+        });
+        if (texture == NULL) {
+            SDL_Log("Failed to create texture %d of pack `%s`", (int) i, fullPath);
+            continue;
+        }
+        pack->textures[i] = texture;
+        
+        Uint64 offset = info->offset - header.dataOffset;
+        for (Uint32 level = 0; level < info->levelCount; level++) {
+            const Uint32 w = SDL_max(info->width >> level, 1);
+            const Uint32 h = SDL_max(info->height >> level, 1);
+            SDL_UploadToGPUTexture(
+                copyPass,
+                &(SDL_GPUTextureTransferInfo) {
+                    .transferBuffer = transferBuffer,
+                    .offset = (Uint32) offset,
+                },
+                &(SDL_GPUTextureRegion){
+                    .texture = texture,
+                    .mipLevel = level,
+                    .w = w,
+                    .h = h,
+                    .d = 1
+                },
+                SDL_FALSE
+            );
+            offset += Texture_Level_Size(format, w, h);
+        }
+    }
+    pack->textureCount = header.textureCount;
+    SDL_EndGPUCopyPass(copyPass);
+    SDL_SubmitGPU(uploadCmdBuf);
+    frameStats.uploadBytes += header.dataSize;
+    frameStats.commandBuffers++;
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    SDL_free(textures);
+    
+    return pack;
+}
+
+int TinyDraw_Find_Pack_Region(TexturePack* pack, const char* name, AtlasRegion* region)
+{
+    for (int i = 0; i < pack->regionCount; i++) {
+        const PackRegion* found = &pack->regions[i];
+        if (SDL_strcmp(found->name, name) != 0) {
+            continue;
+        }
+        
+        if (region != NULL) {
+            *region = (AtlasRegion){
+                .texture = pack->textures[found->texture],
+                .sourcePos = found->sourcePos,
+                .sourceSize = found->sourceSize,
+                .size = { .x = (int) found->width, .y = (int) found->height },
+            };
+        }
+        return 1;
+    }
+    
+    return 0;
+}
+
+void TinyDraw_Unload_Pack(TexturePack* pack)
+{
+    if (pack == NULL) {
+        return;
+    }
+    
+    for (int i = 0; pack->textures != NULL && i < pack->textureCount; i++) {
+        if (pack->textures[i] != NULL) {
+            SDL_ReleaseGPUTexture(device, pack->textures[i]);
+        }
+    }
+    SDL_free(pack->textures);
+    SDL_free(pack->regions);
+    SDL_free(pack);
+}
+
+void TinyDraw_Stage_Sprite(
+    SDL_GPUTexture* texture,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    Color color
+)
+{
+    TinyDraw_Stage_Sprite_Ex(
+        NULL,
+        texture,
+        0,
+        destPos,
+        destSize,
+        sourcePos,
+        sourceSize,
+        color
+    );
+}
+
+void TinyDraw_Stage_Sprite_Ex(
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUTexture* texture,
+    Uint16 layer,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    Color color
+)
+{
+    if (texture == NULL) {
+        SDL_Log("Cannot stage a sprite without a texture");
+        return;
+    }
+    PROFILE_START(start);
+    
+    if (!SpriteBatch_Grow(1)) {
+        return;
+    }
+    
+    const int textureSlot = SpriteBatch_Find_Slot(
+        batchTextures,
+        &batchTextureCount,
+        SPRITE_TEXTURE_MAX,
+        texture
+    );
+    const int pipelineSlot = SpriteBatch_Find_Slot(
+        batchPipelines,
+        &batchPipelineCount,
+        SPRITE_PIPELINE_MAX,
+        pipeline
+    );
+    if (textureSlot < 0 || pipelineSlot < 0) {
+        SDL_Log("Too many textures or pipelines in one batch, dropping sprite");
+        return;
+    }
+    
+    if (batchViewCount == SPRITE_VIEW_MAX) {
+        SDL_Log("Too many renders in one frame, dropping sprite");
+        return;
+    }
+    
+    if (layer > SPRITE_LAYER_MAX) {
+        layer = SPRITE_LAYER_MAX;
+    }
+    
+    spriteBatchKeys[spriteBatchCount] = ((Uint64) batchViewCount << SPRITE_KEY_VIEW_SHIFT)
+        | ((Uint64) layer << SPRITE_KEY_LAYER_SHIFT)
+        | ((Uint64) pipelineSlot << SPRITE_KEY_PIPELINE_SHIFT)
+        | ((Uint64) textureSlot << SPRITE_KEY_TEXTURE_SHIFT)
+        | (Uint64) spriteBatchCount;
+    
+    SpriteBatch_Store_Set(
+        &spriteBatch,
+        spriteBatchCount,
+        destPos,
+        destSize,
+        sourcePos,
+        sourceSize,
+        color
+    );
+    
+    spriteBatchCount++;
+    PROFILE_STOP(start, profileTicks.stage);
+}
+
+void TinyDraw_Stage_Sprite_Rotated(
+    SDL_GPUTexture* texture,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    float2 origin,
+    float rotation,
+    Color color
+)
+{
+    if (spriteBatch.rotation == NULL && !SpriteBatch_Enable_Rotation()) {
+        return;
+    }
+    
+    const int sprite = spriteBatchCount;
+    TinyDraw_Stage_Sprite(texture, destPos, destSize, sourcePos, sourceSize, color);
+    if (spriteBatchCount == sprite) {
+        return;
+    }
+    
+    spriteBatch.rotation[sprite] = (SpriteBatch_Rotation) {
+        .angle = rotation,
+        .origin = origin,
+    };
+}
+
+void TinyDraw_Stage_Sprites(
+    SDL_GPUTexture* texture,
+    const SpriteDesc* sprites,
+    int count
+)
+{
+    if (texture == NULL) {
+        SDL_Log("Cannot stage a sprite without a texture");
+        return;
+    }
+    
+    if (count <= 0 || !SpriteBatch_Grow(count)) {
+        return;
+    }
+    PROFILE_START(start);
+    
+    const int textureSlot = SpriteBatch_Find_Slot(
+        batchTextures,
+        &batchTextureCount,
+        SPRITE_TEXTURE_MAX,
+        texture
+    );
+    if (textureSlot < 0) {
+        SDL_Log("Too many textures or pipelines in one batch, dropping sprites");
+        return;
+    }
+    
+    if (batchViewCount == SPRITE_VIEW_MAX) {
+        SDL_Log("Too many renders in one frame, dropping sprites");
+        return;
+    }
+    
+    // Layer 0 & the view's pipeline, like `TinyDraw_Stage_Sprite`
+    const Uint64 state = ((Uint64) batchViewCount << SPRITE_KEY_VIEW_SHIFT)
+        | ((Uint64) textureSlot << SPRITE_KEY_TEXTURE_SHIFT);
+    
+    Uint64* keys = &spriteBatchKeys[spriteBatchCount];
+    for (int i = 0; i < count; i++) {
+        const int sprite = spriteBatchCount + i;
+        keys[i] = state | (Uint64) sprite;
+        spriteBatch.dest[sprite] = (SpriteBatch_Dest) {
+            .destPos = sprites[i].destPos,
+            .destSize = sprites[i].destSize,
+        };
+        spriteBatch.source[sprite] = (SpriteBatch_Source) {
+            .sourcePos = sprites[i].sourcePos,
+            .sourceSize = sprites[i].sourceSize,
+            .color = sprites[i].color,
+        };
+    }
+    if (spriteBatch.rotation != NULL) {
+        SDL_memset(&spriteBatch.rotation[spriteBatchCount], 0, sizeof(SpriteBatch_Rotation) * count);
+    }
+    
+    spriteBatchCount += count;
+    PROFILE_STOP(start, profileTicks.stage);
+}
+
+StagingContext* TinyDraw_Create_StagingContext(void)
+{
+    StagingContext* context = SDL_calloc(1, sizeof(StagingContext));
+    if (context == NULL) {
+        SDL_Log("Failed to allocate staging context");
+        return NULL;
+    }
+    
+    if (!SpriteBatch_Store_Grow(&context->store, &context->keys, &context->capacity, SPRITE_COUNT)) {
+        TinyDraw_Destroy_StagingContext(context);
+        return NULL;
+    }
+    
+    // Slot 0 is the pipeline passed to `TinyDraw_Render`, like the batch's
+    context->pipelineCount = 1;
+    context->next = stagingContexts;
+    stagingContexts = context;
+    
+    return context;
+}
+
+void TinyDraw_Stage_Sprite_To(
+    StagingContext* context,
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUTexture* texture,
+    Uint16 layer,
+    float2 destPos,
+    float2 destSize,
+    float2 sourcePos,
+    float2 sourceSize,
+    Color color
+)
+{
+    if (texture == NULL) {
+        SDL_Log("Cannot stage a sprite without a texture");
+        return;
+    }
+    
+    if (!SpriteBatch_Store_Grow(
+        &context->store,
+        &context->keys,
+        &context->capacity,
+        (Sint64) context->count + 1
+    )) {
+        return;
+    }
+    
+    const int textureSlot = SpriteBatch_Find_Slot(
+        context->textures,
+        &context->textureCount,
+        SPRITE_TEXTURE_MAX,
+        texture
+    );
+    const int pipelineSlot = SpriteBatch_Find_Slot(
+        context->pipelines,
+        &context->pipelineCount,
+        SPRITE_PIPELINE_MAX,
+        pipeline
+    );
+    if (textureSlot < 0 || pipelineSlot < 0) {
+        SDL_Log("Too many textures or pipelines in one batch, dropping sprite");
+        return;
+    }
+    
+    if (layer > SPRITE_LAYER_MAX) {
+        layer = SPRITE_LAYER_MAX;
+    }
+    
+    context->keys[context->count] = ((Uint64) layer << SPRITE_KEY_LAYER_SHIFT)
+        | ((Uint64) pipelineSlot << SPRITE_KEY_PIPELINE_SHIFT)
+        | ((Uint64) textureSlot << SPRITE_KEY_TEXTURE_SHIFT);
+    
+    SpriteBatch_Store_Set(
+        &context->store,
+        context->count,
+        destPos,
+        destSize,
+        sourcePos,
+        sourceSize,
+        color
+    );
+    
+    context->count++;
+}
+
+void TinyDraw_Destroy_StagingContext(StagingContext* context)
+{
+    if (context == NULL) {
+        return;
+    }
+    
+    for (StagingContext** link = &stagingContexts; *link != NULL; link = &(*link)->next) {
+        if (*link == context) {
+            *link = context->next;
+            break;
+        }
+    }
+    
+    SpriteBatch_Store_Free(&context->store);
+    SDL_free(context->keys);
+    SDL_free(context);
+}
+
+StaticLayer* TinyDraw_Bake_StaticLayer(void)
+{
+    const int first = batchViewSpriteCount;
+    const int spriteCount = spriteBatchCount - first;
+    if (spriteCount == 0) {
+        SDL_Log("Nothing staged to bake into a static layer");
+        return NULL;
+    }
+    
+    // Only the sprites of the pending view are sorted, everything else stays
+    // where `SpriteBatch_Sort` expects it
+    SDL_qsort(&spriteBatchKeys[first], spriteCount, sizeof(Uint64), SpriteBatch_Compare_Keys);
+    
+    StaticLayer* layer = SDL_calloc(1, sizeof(StaticLayer));
+    if (layer == NULL) {
+        SDL_Log("Failed to allocate static layer");
+        return NULL;
+    }
+    
+    // Runs are split so every draw fits the 16-bit index buffer
+    const Uint64 stateMask = ~((1ull << SPRITE_KEY_SPRITE_BITS) - 1);
+    int drawCapacity = 0;
+    for (int i = first; i < spriteBatchCount; ) {
+        const Uint64 state = spriteBatchKeys[i] & stateMask;
+        int last = i + 1;
+        while (
+            last < spriteBatchCount
+            && last - i < SPRITE_COUNT_16BIT
+            && (spriteBatchKeys[last] & stateMask) == state
+        ) {
+            last++;
+        }
+        
+        if (layer->drawCount == drawCapacity) {
+            drawCapacity = drawCapacity ? drawCapacity * 2 : 8;
+            StaticLayer_Draw* draws = SDL_realloc(layer->draws, sizeof(StaticLayer_Draw) * drawCapacity);
+            if (draws == NULL) {
+                SDL_Log("Failed to allocate static layer");
+                TinyDraw_Destroy_StaticLayer(layer);
+                return NULL;
+            }
+            layer->draws = draws;
+        }
+        
+        SDL_GPUGraphicsPipeline* pipeline = batchPipelines[SPRITE_KEY_FIELD(state, SPRITE_KEY_PIPELINE_SHIFT, 7)];
+        if (pipeline != NULL && Pipeline_Mode(pipeline) != PIPELINE_MODE_VERTEX) {
+            SDL_Log("Instanced & storage pipelines can't be baked into a static layer");
+            TinyDraw_Destroy_StaticLayer(layer);
+            return NULL;
+        }
+        
+        layer->draws[layer->drawCount++] = (StaticLayer_Draw) {
+            .pipeline = pipeline,
+            .texture = batchTextures[SPRITE_KEY_FIELD(state, SPRITE_KEY_TEXTURE_SHIFT, 12)],
+            .first = i - first,
+            .count = last - i,
+        };
+        
+        i = last;
+    }
+    
+    if (!StaticLayer_Upload(layer, &spriteBatch, &spriteBatchKeys[first], spriteCount)) {
+        TinyDraw_Destroy_StaticLayer(layer);
+        return NULL;
+    }
+    
+    // The baked sprites are no longer part of the batch
+    spriteBatchCount = first;
+    
+    return layer;
+}
 
-static matrix4x4 Matrix4x4_CreateOrthographicOffCenter(
-    float left,
-    float right,
-    float bottom,
-    float top,
-    float zNearPlane,
-    float zFarPlane
-) {
-    return (matrix4x4){
-        2.0f / (right - left), 0, 0, 0,
-        0, 2.0f / (top - bottom), 0, 0,
-        0, 0, 1.0f / (zNearPlane - zFarPlane), 0,
-        (left + right) / (left - right), (top + bottom) / (bottom - top), zNearPlane / (zNearPlane - zFarPlane), 1
-    };
+void TinyDraw_Stage_StaticLayer(StaticLayer* layer)
+{
+    if (layer == NULL) {
+        return;
+    }
+    
+    if (batchStaticCount == SPRITE_STATIC_MAX) {
+        SDL_Log("Too many static layers in one frame, dropping layer");
+        return;
+    }
+    
+    batchStaticLayers[batchStaticCount++] = layer;
 }
 
-// Public Methods
+void TinyDraw_Destroy_StaticLayer(StaticLayer* layer)
+{
+    if (layer == NULL) {
+        return;
+    }
+    
+    if (layer->buffer != NULL) {
+        SDL_ReleaseGPUBuffer(device, layer->buffer);
+    }
+    SDL_free(layer->draws);
+    SDL_free(layer);
+}
 
-int TinyDraw_Init(void)
+Tilemap* TinyDraw_Create_Tilemap(
+    SDL_GPUTexture* tileset,
+    int2 tilesetSize,
+    int2 tileSize,
+    int width,
+    int height
+)
 {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
-        return 0;
+    if (tileset == NULL || tileSize.x <= 0 || tileSize.y <= 0 || width <= 0 || height <= 0) {
+        SDL_Log("Cannot create a tilemap without a tileset or size");
+        return NULL;
     }
     
-    device = SDL_CreateGPUDevice(SDL_ShaderCross_GetShaderFormats(), SDL_TRUE, NULL);
-    if (device == NULL) {
-        SDL_Log("Failed to create GPU device");
-        return 0;
+    Tilemap* tilemap = SDL_calloc(1, sizeof(Tilemap));
+    if (tilemap == NULL) {
+        SDL_Log("Failed to allocate tilemap");
+        return NULL;
     }
     
-    window = SDL_CreateWindow(title, sizeWindow.x, sizeWindow.y, 0);
-    if (window == NULL) {
-        SDL_Log("Failed to create window: %s", SDL_GetError());
-        return 0;
+    tilemap->tileset = tileset;
+    tilemap->tilesetSize = tilesetSize;
+    tilemap->tileSize = tileSize;
+    tilemap->width = width;
+    tilemap->height = height;
+    tilemap->chunkCount = (int2){
+        .x = (width + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE,
+        .y = (height + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE,
+    };
+    tilemap->tiles = SDL_calloc((size_t) width * height, sizeof(Uint16));
+    tilemap->chunks = SDL_calloc((size_t) tilemap->chunkCount.x * tilemap->chunkCount.y, sizeof(Tilemap_Chunk));
+    if (tilemap->tiles == NULL || tilemap->chunks == NULL) {
+        SDL_Log("Failed to allocate tilemap");
+        TinyDraw_Destroy_Tilemap(tilemap);
+        return NULL;
     }
     
-    if (!SDL_ClaimGPUWindow(device, window)) {
-        SDL_Log("Failed to claim window");
-        return 0;
+    return tilemap;
+}
+
+void TinyDraw_Set_Tile(Tilemap* tilemap, int x, int y, int tile)
+{
+    if (x < 0 || y < 0 || x >= tilemap->width || y >= tilemap->height) {
+        return;
+    }
+    // Stored plus one, so 0 is none
+    if (tile < -1 || tile >= SDL_MAX_UINT16) {
+        SDL_Log("Invalid tile index %d, expected -1 to %d", tile, SDL_MAX_UINT16 - 1);
+        return;
     }
     
-    basePath = SDL_GetBasePath();
+    const Uint16 value = (Uint16) (tile + 1);
+    Uint16* current = &tilemap->tiles[y * tilemap->width + x];
+    if (*current == value) {
+        return;
+    }
     
-    sampler = SDL_CreateGPUSampler(device, &(SDL_GPUSamplerCreateInfo){
-        .minFilter = SDL_GPU_FILTER_NEAREST,
-        .magFilter = SDL_GPU_FILTER_NEAREST,
-        .mipmapMode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
-        .addressModeU = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
-        .addressModeV = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
-        .addressModeW = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
-    });
+    *current = value;
+    tilemap->chunks[(y / TILEMAP_CHUNK_SIZE) * tilemap->chunkCount.x + x / TILEMAP_CHUNK_SIZE].dirty = 1;
+}
+
+int TinyDraw_Get_Tile(Tilemap* tilemap, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= tilemap->width || y >= tilemap->height) {
+        return -1;
+    }
     
-    vertexBuffer = SDL_CreateGPUBuffer(
-        device,
-        &(SDL_GPUBufferCreateInfo) {
-            .usageFlags = SDL_GPU_BUFFERUSAGE_VERTEX_BIT,
-            .sizeInBytes = sizeof(Vertex) * 4 * SPRITE_COUNT
-        }
-    );
-    SDL_SetGPUBufferName(
-        device,
-        vertexBuffer,
-        "TinyDraw Vertex Buffer"
-    );
+    return tilemap->tiles[y * tilemap->width + x] - 1;
+}
+
+void TinyDraw_Stage_Tilemap(Tilemap* tilemap, float3 camera, SDL_GPUTexture* renderTarget)
+{
+    if (tilemap == NULL) {
+        return;
+    }
+    PROFILE_START(start);
     
-    indexBuffer = SDL_CreateGPUBuffer(
-        device,
-        &(SDL_GPUBufferCreateInfo) {
-            .usageFlags = SDL_GPU_BUFFERUSAGE_INDEX_BIT,
-            .sizeInBytes = sizeof(Uint16) * 6 * SPRITE_COUNT
-        }
-    );
-    SDL_SetGPUBufferName(
-        device,
-        vertexBuffer,
-        "TinyDraw Index Buffer"
-    );
-    SDL_GPUTransferBuffer* bufferTransferBuffer = SDL_CreateGPUTransferBuffer(
-        device,
-        &(SDL_GPUTransferBufferCreateInfo) {
-            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .sizeInBytes = (sizeof(Vertex) * 4 * SPRITE_COUNT) + (sizeof(Uint16) * 6 * SPRITE_COUNT)
+    // The view rectangle of `Camera_Matrix` on the target, in chunks
+    const float2 size = Camera_Size(camera, RenderTarget_Size(renderTarget));
+    const float chunkWidth = (float) tilemap->tileSize.x * TILEMAP_CHUNK_SIZE;
+    const float chunkHeight = (float) tilemap->tileSize.y * TILEMAP_CHUNK_SIZE;
+    const int firstX = SDL_max((int) SDL_floorf(camera.x / chunkWidth), 0);
+    const int firstY = SDL_max((int) SDL_floorf(camera.y / chunkHeight), 0);
+    const int lastX = SDL_min((int) SDL_floorf((camera.x + size.x) / chunkWidth), tilemap->chunkCount.x - 1);
+    const int lastY = SDL_min((int) SDL_floorf((camera.y + size.y) / chunkHeight), tilemap->chunkCount.y - 1);
+    
+    for (int y = firstY; y <= lastY; y++) {
+        for (int x = firstX; x <= lastX; x++) {
+            Tilemap_Chunk* chunk = &tilemap->chunks[y * tilemap->chunkCount.x + x];
+            if (chunk->dirty) {
+                Tilemap_Build_Chunk(tilemap, x, y);
+            }
+            
+            if (chunk->layer != NULL && chunk->layer->drawCount) {
+                TinyDraw_Stage_StaticLayer(chunk->layer);
+            }
         }
-    );
-    Vertex* transferData = SDL_MapGPUTransferBuffer(
-        device,
-        bufferTransferBuffer,
-        SDL_FALSE
-    );
-    Uint16* indexData = (Uint16*) &transferData[4 * SPRITE_COUNT];
-    for (int i = 0; i < SPRITE_COUNT; i++) {
-        const int u = i * 6;
-        const int v = i * 4;
-        indexData[u + 0] = v + 0;
-        indexData[u + 1] = v + 1;
-        indexData[u + 2] = v + 2;
-        indexData[u + 3] = v + 0;
-        indexData[u + 4] = v + 2;
-        indexData[u + 5] = v + 3;
     }
-    SDL_UnmapGPUTransferBuffer(device, bufferTransferBuffer);
-    SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(device);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuf);
-    SDL_UploadToGPUBuffer(
-        copyPass,
-        &(SDL_GPUTransferBufferLocation) {
-            .transferBuffer = bufferTransferBuffer,
-            .offset = sizeof(Vertex) * 4 * SPRITE_COUNT
-        },
-        &(SDL_GPUBufferRegion) {
-            .buffer = indexBuffer,
-            .offset = 0,
-            .size = sizeof(Uint16) * 6 * SPRITE_COUNT
-        },
-        SDL_FALSE
-    );
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPU(uploadCmdBuf);
-    SDL_ReleaseGPUTransferBuffer(device, bufferTransferBuffer);
-    
-    return 1;
+    PROFILE_STOP(start, profileTicks.stage);
 }
 
-void TinyDraw_Resize(int width, int height, char fullscreen)
+void TinyDraw_Destroy_Tilemap(Tilemap* tilemap)
 {
-    SDL_SetWindowFullscreen(window, fullscreen ? SDL_WINDOW_FULLSCREEN : 0);
+    if (tilemap == NULL) {
+        return;
+    }
     
-    if (!fullscreen) {
-        SDL_SetWindowSize(window, width, height);
+    if (tilemap->chunks != NULL) {
+        for (int i = 0; i < tilemap->chunkCount.x * tilemap->chunkCount.y; i++) {
+            TinyDraw_Destroy_StaticLayer(tilemap->chunks[i].layer);
+        }
     }
+    SDL_free(tilemap->chunks);
+    SDL_free(tilemap->tiles);
+    SDL_free(tilemap);
 }
 
-SDL_GPUTexture* TinyDraw_Create_RenderTarget(int width, int height)
+/**
+ * Forget the oldest frame in flight, once the GPU has finished it.
+ */
+static void Frame_Retire(void)
 {
-    SDL_GPUTexture* renderTarget = SDL_CreateGPUTexture(device,
-        &(SDL_GPUTextureCreateInfo){
-            .type = SDL_GPU_TEXTURETYPE_2D,
-            .format = SDL_GetGPUSwapchainTextureFormat(device, window),
-            .width = width,
-            .height = height,
-            .layerCountOrDepth = 1,
-            .levelCount = 1,
-            .usageFlags = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET_BIT | SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT,
-        }
-    );
+    frameLatency = (SDL_GetTicksNS() - frameFences[0].start) / 1000000.0;
+    SDL_ReleaseGPUFence(device, frameFences[0].fence);
+    frameFinishedCount++;
+    frameFenceCount--;
+    SDL_memmove(&frameFences[0], &frameFences[1], sizeof(Frame_Fence) * frameFenceCount);
+}
+
+/**
+ * Retire every frame the GPU has finished, without waiting.
+ */
+static void Frame_Poll(void)
+{
+    // Frames finish in order, so only the oldest needs checking
+    while (frameFenceCount > 0 && SDL_QueryGPUFence(device, frameFences[0].fence)) {
+        Frame_Retire();
+    }
+}
+
+/**
+ * Keep track of a submitted frame, & wait until few enough are in flight.
+ */
+static void Frame_Track(SDL_GPUFence* fence)
+{
+    Frame_Poll();
     
-    return renderTarget;
+    if (fence == NULL) {
+        return;
+    }
+    frameFences[frameFenceCount++] = (Frame_Fence){
+        .fence = fence,
+        .start = frameStart,
+    };
+    frameSubmittedCount++;
+    
+    while (frameFenceCount >= frameFenceLimit) {
+        SDL_WaitForGPUFences(device, SDL_TRUE, &frameFences[0].fence, 1);
+        Frame_Retire();
+    }
 }
 
-SDL_GPUGraphicsPipeline* TinyDraw_Create_Pipeline(
-    SDL_GPUShader* vertexShader,
-    SDL_GPUShader* fragmentShader
-)
+/**
+ * Record the download of every readback requested this frame.
+ */
+static void Readback_Record(SDL_GPUCommandBuffer* cmdbuf)
 {
-    SDL_GPUGraphicsPipelineCreateInfo info = {
-        .attachmentInfo = {
-            .colorAttachmentCount = 1,
-            .colorAttachmentDescriptions = (SDL_GPUColorAttachmentDescription[]){{
-                .format = SDL_GetGPUSwapchainTextureFormat(device, window),
-                .blendState = {
-                    .blendEnable = SDL_TRUE,
-                    .alphaBlendOp = SDL_GPU_BLENDOP_ADD,
-                    .colorBlendOp = SDL_GPU_BLENDOP_ADD,
-                    .colorWriteMask = 0xF,
-                    .srcColorBlendFactor = SDL_GPU_BLENDFACTOR_ONE,
-                    .srcAlphaBlendFactor = SDL_GPU_BLENDFACTOR_ONE,
-                    .dstColorBlendFactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
-                    .dstAlphaBlendFactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+    SDL_GPUCopyPass* copyPass = NULL;
+    for (int i = 0; i < TINYDRAW_READBACK_MAX; i++) {
+        Readback_Slot* slot = &readbackSlots[i];
+        if (slot->state != READBACK_REQUESTED) {
+            continue;
+        }
+        
+        const Uint32 size = (Uint32) slot->size.x * slot->size.y * 4;
+        if (size > slot->capacity) {
+            if (slot->transferBuffer != NULL) {
+                SDL_ReleaseGPUTransferBuffer(device, slot->transferBuffer);
+            }
+            slot->transferBuffer = SDL_CreateGPUTransferBuffer(
+                device,
+                &(SDL_GPUTransferBufferCreateInfo) {
+                    .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+                    .sizeInBytes = size
                 }
-            }},
-        },
-        .vertexInputState = (SDL_GPUVertexInputState){
-            .vertexBindingCount = 1,
-            .vertexBindings = (SDL_GPUVertexBinding[]){{
-                .binding = 0,
-                .inputRate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-                .instanceStepRate = 0,
-                .stride = sizeof(Vertex)
-            }},
-            .vertexAttributeCount = 3,
-            .vertexAttributes = (SDL_GPUVertexAttribute[]){
-                {
-                    .binding = 0,
-                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-                    .location = 0,
-                    .offset = 0,
-                },
-                {
-                    .binding = 0,
-                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-                    .location = 1,
-                    .offset = sizeof(float) * 3,
-                },
-                {
-                    .binding = 0,
-                    .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
-                    .location = 2,
-                    .offset = sizeof(float) * 5,
-                },
+            );
+            slot->capacity = slot->transferBuffer != NULL ? size : 0;
+            if (slot->transferBuffer == NULL) {
+                SDL_Log("Failed to create readback buffer");
+                slot->state = READBACK_FREE;
+                continue;
+            }
+        }
+        
+        if (copyPass == NULL) {
+            copyPass = SDL_BeginGPUCopyPass(cmdbuf);
+        }
+        SDL_DownloadFromGPUTexture(
+            copyPass,
+            &(SDL_GPUTextureRegion){
+                .texture = slot->texture,
+                .w = slot->size.x,
+                .h = slot->size.y,
+                .d = 1
             },
-        },
-        .multisampleState.sampleMask = 0xFFFF,
-        .primitiveType = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-        .vertexShader = vertexShader,
-        .fragmentShader = fragmentShader,
-        // TODO: depth stencil state here
-    };
+            &(SDL_GPUTextureTransferInfo) {
+                .transferBuffer = slot->transferBuffer,
+                .offset = 0,
+            }
+        );
+        slot->state = READBACK_RECORDED;
+    }
     
-    return SDL_CreateGPUGraphicsPipeline(
-        device,
-        &info
-    );
+    if (copyPass != NULL) {
+        SDL_EndGPUCopyPass(copyPass);
+    }
 }
 
-SDL_GPUShader* TinyDraw_Load_Shader(
-    const char* fileName,
-    Uint32 samplerCount,
-    Uint32 uniformBufferCount,
-    Uint32 storageBufferCount,
-    Uint32 storageTextureCount,
-    SDL_GPUShaderStage stage
-)
+/**
+ * Hand the pixels of every readback whose frame has finished to its
+ * callback. With `submitted`, readbacks recorded this frame are tied to the
+ * frame just submitted, otherwise it had no fence & they are dropped.
+ */
+static void Readback_Deliver(char submitted)
 {
-    SDL_snprintf(
-        fullPath,
-        sizeof(fullPath),
-        "%sContent/shaders/%s.spv",
-        basePath,
-        fileName
-    );
-    
-    size_t codeSize;
-    void* code = SDL_LoadFile(fullPath, &codeSize);
-    if (code == NULL) {
-        SDL_Log("Failed to load shader from disk! %s", fullPath);
-        return NULL;
+    for (int i = 0; i < TINYDRAW_READBACK_MAX; i++) {
+        Readback_Slot* slot = &readbackSlots[i];
+        if (slot->state == READBACK_RECORDED) {
+            slot->state = submitted ? READBACK_SUBMITTED : READBACK_FREE;
+            slot->frame = frameSubmittedCount;
+        }
+        if (slot->state != READBACK_SUBMITTED || slot->frame > frameFinishedCount) {
+            continue;
+        }
+        
+        const Uint8* pixels = SDL_MapGPUTransferBuffer(device, slot->transferBuffer, SDL_FALSE);
+        if (pixels != NULL) {
+            slot->callback(slot->userdata, pixels, slot->size.x, slot->size.y, RenderTarget_Format());
+            SDL_UnmapGPUTransferBuffer(device, slot->transferBuffer);
+        }
+        slot->state = READBACK_FREE;
+    }
+}
+
+/**
+ * Sleep until the frame's deadline, & start the next frame.
+ */
+static void Frame_Pace(void)
+{
+    if (framePeriod) {
+        const Uint64 now = SDL_GetTicksNS();
+        frameDeadline += framePeriod;
+        if (frameDeadline < now) {
+            frameDeadline = now;
+        } else {
+            if (frameDeadline - now > FRAME_SPIN) {
+                SDL_DelayNS(frameDeadline - now - FRAME_SPIN);
+            }
+            while (SDL_GetTicksNS() < frameDeadline) {
+                FRAME_SPIN_PAUSE();
+            }
+        }
     }
     
-    SDL_GPUShader* shader;
-    SDL_GPUShaderCreateInfo shaderInfo = {
-        .code = code,
-        .codeSize = codeSize,
-        .entryPointName = "main",
-        .format = SDL_GPU_SHADERFORMAT_SPIRV,
-        .stage = stage,
-        .samplerCount = samplerCount,
-        .uniformBufferCount = uniformBufferCount,
-        .storageBufferCount = storageBufferCount,
-        .storageTextureCount = storageTextureCount
-    };
-    
-    if (SDL_GetGPUDriver(device) == SDL_GPU_DRIVER_VULKAN) {
-        shader = SDL_CreateGPUShader(device, &shaderInfo);
-    } else {
-        shader = SDL_ShaderCross_CompileFromSPIRV(device, &shaderInfo, SDL_FALSE);
+    frameStart = SDL_GetTicksNS();
+}
+
+void TinyDraw_BeginFrame(void)
+{
+    if (frameCommandBuffer != NULL) {
+        SDL_Log("TinyDraw_BeginFrame called twice without TinyDraw_EndFrame");
+        return;
     }
     
-    if (shader == NULL) {
-        SDL_Log("Failed to create shader!");
-        SDL_free(code);
-        return NULL;
+    frameCommandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    if (frameCommandBuffer == NULL) {
+        SDL_Log("GPUAcquireCommandBuffer failed");
+        return;
     }
     
-    SDL_free(code);
+    // Sees frames finished while pacing slept, for a closer `latency`
+    Frame_Poll();
     
-    return shader;
+    if (textureLoadMutex != NULL) {
+        TextureLoad_Upload_Decoded(frameCommandBuffer);
+    }
 }
 
-SDL_GPUTexture* TinyDraw_Load_Texture(
-    const char* fileName,
-    int* width,
-    int* height
-)
+/**
+ * `TinyDraw_EndFrame`, pacing only when it's not a `TinyDraw_Render` outside
+ * of a frame.
+ */
+static void Frame_End(char pace)
 {
-    SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/sprites/%s", basePath, fileName);
-    int w, h, comp;
-    unsigned char* pixels = stbi_load(fullPath, &w, &h, &comp, 0);
-    if (pixels == NULL) {
-        SDL_Log("Failed to load image `%s`\n", fullPath);
-        return NULL;
+    SDL_GPUCommandBuffer* cmdbuf = frameCommandBuffer;
+    if (cmdbuf == NULL) {
+        SDL_Log("TinyDraw_EndFrame called without TinyDraw_BeginFrame");
+        SpriteBatch_Reset();
+        if (pace) {
+            Frame_Pace();
+        }
+        return;
     }
+    frameCommandBuffer = NULL;
+    PROFILE_START(flushStart);
     
-    if (width != NULL) {
-        *width = w;
+    frameStats.spritesStaged = batchViewSpriteCount;
+    if (cullEnabled) {
+        SpriteBatch_Cull();
     }
     
-    if (height != NULL) {
-        *height = h;
+    if (depthEnabled) {
+        SpriteBatch_Order_Opaque();
     }
+    const int largestDraw = SpriteBatch_Sort();
     
-    SDL_GPUTexture* texture = SDL_CreateGPUTexture(device, &(SDL_GPUTextureCreateInfo){
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
-        .width = w,
-        .height = h,
-        .layerCountOrDepth = 1,
-        .levelCount = 1,
-        .usageFlags = SDL_GPU_TEXTUREUSAGE_SAMPLER_BIT
-    });
+    if (
+        !SpriteBatch_Reserve_Buffer(&vertexStream, sizeof(Vertex) * 4 * batchVertexSpriteCount)
+        || !SpriteBatch_Reserve_Buffer(&instanceStream, sizeof(SpriteInstance) * batchInstanceCount)
+        || !SpriteBatch_Reserve_Buffer(&storageStream, sizeof(SpriteInstance) * batchStorageCount)
+    ) {
+        for (int v = 0; v < batchViewCount; v++) {
+            batchViews[v].drawCount = 0;
+        }
+        batchDrawCount = 0;
+        batchVertexSpriteCount = 0;
+        batchInstanceCount = 0;
+        batchStorageCount = 0;
+    }
     
-    SDL_GPUTransferBuffer* textureTransferBuffer = SDL_CreateGPUTransferBuffer(
-        device,
-        &(SDL_GPUTransferBufferCreateInfo) {
-            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .sizeInBytes = w * h * 4
+    if (batchDrawCount) {
+        Vertex* vertexData = batchVertexSpriteCount
+            ? SDL_MapGPUTransferBuffer(device, vertexStream.transferBuffer, SDL_TRUE)
+            : NULL;
+        SpriteInstance* instanceData = batchInstanceCount
+            ? SDL_MapGPUTransferBuffer(device, instanceStream.transferBuffer, SDL_TRUE)
+            : NULL;
+        SpriteInstance* storageData = batchStorageCount
+            ? SDL_MapGPUTransferBuffer(device, storageStream.transferBuffer, SDL_TRUE)
+            : NULL;
+        SpriteBatch_Pack(vertexData, instanceData, storageData);
+        if (vertexData != NULL) {
+            SDL_UnmapGPUTransferBuffer(device, vertexStream.transferBuffer);
         }
-    );
-    Uint8* textureTransferPtr = SDL_MapGPUTransferBuffer(
-        device,
-        textureTransferBuffer,
-        SDL_FALSE
-    );
-    SDL_memcpy(textureTransferPtr, pixels, w * h * 4);
-    SDL_UnmapGPUTransferBuffer(device, textureTransferBuffer);
+        if (instanceData != NULL) {
+            SDL_UnmapGPUTransferBuffer(device, instanceStream.transferBuffer);
+        }
+        if (storageData != NULL) {
+            SDL_UnmapGPUTransferBuffer(device, storageStream.transferBuffer);
+        }
+        
+        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdbuf);
+        // Past 65535 vertices a single draw needs 32-bit indices
+        if (largestDraw > SPRITE_COUNT_16BIT && largestDraw > indexBuffer32Capacity) {
+            if (indexBuffer32 != NULL) {
+                SDL_ReleaseGPUBuffer(device, indexBuffer32);
+            }
+            const int capacity = vertexStream.size / (sizeof(Vertex) * 4);
+            indexBuffer32 = SpriteBatch_Create_IndexBuffer(
+                copyPass,
+                capacity,
+                SDL_GPU_INDEXELEMENTSIZE_32BIT
+            );
+            indexBuffer32Capacity = indexBuffer32 ? capacity : 0;
+        }
+        SpriteBatch_Upload_Buffer(copyPass, &vertexStream, sizeof(Vertex) * 4 * batchVertexSpriteCount);
+        SpriteBatch_Upload_Buffer(copyPass, &instanceStream, sizeof(SpriteInstance) * batchInstanceCount);
+        SpriteBatch_Upload_Buffer(copyPass, &storageStream, sizeof(SpriteInstance) * batchStorageCount);
+        SDL_EndGPUCopyPass(copyPass);
+    }
     
-    SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(device);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuf);
-    SDL_UploadToGPUTexture(
-        copyPass,
-        &(SDL_GPUTextureTransferInfo) {
-            .transferBuffer = textureTransferBuffer,
-            .offset = 0,
-        },
-        &(SDL_GPUTextureRegion){
-            .texture = texture,
-            .w = w,
-            .h = h,
-            .d = 1
-        },
-        SDL_FALSE
-    );
-    stbi_image_free(pixels);
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPU(uploadCmdBuf);
-    SDL_ReleaseGPUTransferBuffer(device, textureTransferBuffer);
+    SpriteBatch_Build_Passes();
+    Transient_Assign();
+    PROFILE_STOP(flushStart, profileTicks.flush);
+    PROFILE_START(submitStart);
     
-    return texture;
+    // Acquired by the first pass drawing to the screen
+    SDL_GPUTexture* swapchainTexture = NULL;
+    char swapchainAcquired = 0;
+    Uint32 w = 0, h = 0;
+    char droppedStatic = 0;
+    for (int p = 0; p < batchPassCount; p++) {
+        const SpriteBatch_Pass* pass = &batchPasses[p];
+        SDL_GPUTexture* renderTarget = batchTargets[pass->target];
+        
+        if (renderTarget == NULL && !swapchainAcquired && window != NULL) {
+            swapchainTexture = SDL_AcquireGPUSwapchainTexture(cmdbuf, window, &w, &h);
+            swapchainAcquired = 1;
+        }
+        const Transient_Target* transient = Transient_Find(renderTarget);
+        SDL_GPUTexture* texture = renderTarget == NULL
+            ? swapchainTexture
+            : transient != NULL
+                ? transient->texture
+                : renderTarget;
+        if (texture == NULL) {
+            continue;
+        }
+        
+        SDL_GPUColorAttachmentInfo colorAttachmentInfo = { 0 };
+        colorAttachmentInfo.texture = texture;
+        colorAttachmentInfo.clearColor = (SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f };
+        colorAttachmentInfo.loadOp = pass->loadOp;
+        colorAttachmentInfo.storeOp = pass->storeOp;
+        
+        // Depth only matters within the pass, so it is never loaded or stored
+        SDL_GPUDepthStencilAttachmentInfo depthAttachmentInfo = { 0 };
+        if (depthEnabled) {
+            const int2 size = renderTarget
+                ? RenderTarget_Size(renderTarget)
+                : (int2){ .x = (int) w, .y = (int) h };
+            depthAttachmentInfo.texture = Depth_Target_For_Size(size.x, size.y);
+            if (depthAttachmentInfo.texture == NULL) {
+                continue;
+            }
+            depthAttachmentInfo.depthStencilClearValue.depth = 1.0f;
+            depthAttachmentInfo.loadOp = SDL_GPU_LOADOP_CLEAR;
+            depthAttachmentInfo.storeOp = SDL_GPU_STOREOP_DONT_CARE;
+            depthAttachmentInfo.stencilLoadOp = SDL_GPU_LOADOP_DONT_CARE;
+            depthAttachmentInfo.stencilStoreOp = SDL_GPU_STOREOP_DONT_CARE;
+        }
+        
+        SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(
+            cmdbuf,
+            &colorAttachmentInfo,
+            1,
+            depthEnabled ? &depthAttachmentInfo : NULL
+        );
+        frameStats.renderPasses++;
+        if (renderTarget == NULL) {
+            const SDL_GPUViewport viewport = Screen_Viewport(w, h);
+            SDL_SetGPUViewport(renderPass, &viewport);
+        }
+        
+        SpriteBatch_Binding bound = { 0 };
+        for (int v = 0; v < batchViewCount; v++) {
+            const SpriteBatch_View* view = &batchViews[v];
+            if (view->pass != p || view->skip) {
+                continue;
+            }
+            
+            const SpriteBatch_View* source = view->source >= 0
+                ? &batchViews[view->source]
+                : NULL;
+            if (
+                view->drawCount == 0
+                && view->staticCount == 0
+                && (source == NULL || (source->drawCount == 0 && source->staticCount == 0))
+            ) {
+                continue;
+            }
+            
+            SDL_PushGPUVertexUniformData(
+                cmdbuf,
+                0,
+                &view->camera,
+                sizeof(matrix4x4)
+            );
+            
+            // The replayed source view first, then this view's own sprites
+            if (source != NULL) {
+                droppedStatic |= SpriteBatch_Draw_View(cmdbuf, renderPass, &bound, source);
+            }
+            droppedStatic |= SpriteBatch_Draw_View(cmdbuf, renderPass, &bound, view);
+        }
+        
+        SDL_EndGPURenderPass(renderPass);
+    }
+    
+    if (droppedStatic) {
+        SDL_Log("Instanced & storage pipelines can't draw static layers & tilemaps, dropping them");
+    }
+    
+    Readback_Record(cmdbuf);
+    
+    SDL_GPUFence* fence = SDL_SubmitGPUAndAcquireFence(cmdbuf);
+    frameStats.commandBuffers++;
+    PROFILE_STOP(submitStart, profileTicks.submit);
+    Frame_Track(fence);
+    Readback_Deliver(fence != NULL);
+    
+    // Ticks to milliseconds, & start counting the next frame
+    const double tickTime = 1000.0 / (double) SDL_GetPerformanceFrequency();
+    frameStats.stageTime = profileTicks.stage * tickTime;
+    frameStats.renderTime = profileTicks.render * tickTime;
+    frameStats.flushTime = profileTicks.flush * tickTime;
+    frameStats.submitTime = profileTicks.submit * tickTime;
+    frameStats.latency = frameLatency;
+    frameStatsLast = frameStats;
+    frameStats = (FrameStats){ 0 };
+    profileTicks = (Profile_Ticks){ 0 };
+    
+    SpriteBatch_Reset();
+    
+    if (pace) {
+        Frame_Pace();
+    }
 }
 
-void TinyDraw_Stage_Sprite(
-    float2 destPos,
-    float2 destSize,
-    float2 sourcePos,
-    float2 sourceSize,
-    Color color
-)
+void TinyDraw_EndFrame(void)
 {
-    SDL_GPUCommandBuffer* cmdbuf = SDL_AcquireGPUCommandBuffer(device);
-    if (cmdbuf == NULL) {
-        SDL_Log("GPUAcquireCommandBuffer failed");
-        return;
+    Frame_End(1);
+}
+
+void TinyDraw_Set_Frame_Pacing(int fps, int framesInFlight)
+{
+    framePeriod = fps > 0 ? 1000000000ull / fps : 0;
+    frameFenceLimit = SDL_clamp(framesInFlight, 1, TINYDRAW_FRAMES_IN_FLIGHT_MAX);
+}
+
+int TinyDraw_Set_Present_Mode(SDL_GPUPresentMode mode)
+{
+    if (window == NULL) {
+        return 0;
     }
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdbuf);
-    SDL_GPUTransferBuffer* bufferTransferBuffer = SDL_CreateGPUTransferBuffer(
-        device,
-        &(SDL_GPUTransferBufferCreateInfo) {
-            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .sizeInBytes = (sizeof(Vertex) * 4 * SPRITE_COUNT) + (sizeof(Uint16) * 6 * SPRITE_COUNT)
-        }
-    );
-    Vertex* transferData = SDL_MapGPUTransferBuffer(
-        device,
-        bufferTransferBuffer,
-        SDL_FALSE
-    );
     
-    transferData[0] = (Vertex) {
-        .x = destPos.x,
-        .y = destPos.y,
-        .z = 0,
-        .u = sourcePos.x,
-        .v = sourcePos.y,
-        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
-    };
-    transferData[1] = (Vertex) {
-        .x = destPos.x + destSize.x,
-        .y = destPos.y,
-        .z = 0,
-        .u = sourcePos.x + sourceSize.x,
-        .v = sourcePos.y,
-        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
-    };
-    transferData[2] = (Vertex) {
-        .x = destPos.x + destSize.x,
-        .y = destPos.y + destSize.y,
-        .z = 0,
-        .u = sourcePos.x + sourceSize.x,
-        .v = sourcePos.y + sourceSize.y,
-        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
-    };
-    transferData[3] = (Vertex) {
-        .x = destPos.x,
-        .y = destPos.y + destSize.y,
-        .z = 0,
-        .u = sourcePos.x,
-        .v = sourcePos.y + sourceSize.y,
-        .r = color.r, .g = color.g, .b = color.b, .a = color.a,
-    };
+    if (!SDL_WindowSupportsGPUPresentMode(device, window, mode)) {
+        SDL_Log("Present mode %d isn't supported by this window", (int) mode);
+        return 0;
+    }
     
-    spriteBatchCount++;
+    if (!SDL_SetGPUSwapchainParameters(device, window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, mode)) {
+        SDL_Log("Failed to set present mode: %s", SDL_GetError());
+        return 0;
+    }
     
-    SDL_UploadToGPUBuffer(
-        copyPass,
-        &(SDL_GPUTransferBufferLocation) {
-            .transferBuffer = bufferTransferBuffer,
-            .offset = 0
-        },
-        &(SDL_GPUBufferRegion) {
-            .buffer = vertexBuffer,
-            .offset = 0,
-            .size = sizeof(Vertex) * 4 * spriteBatchCount
-        },
-        SDL_FALSE
-    );
-    SDL_UnmapGPUTransferBuffer(device, bufferTransferBuffer);
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPU(cmdbuf);
+    return 1;
 }
 
 void TinyDraw_Render(
     SDL_GPUGraphicsPipeline* pipeline,
-    SDL_GPUTexture* texture,
     float3 camera,
     SDL_GPUTexture* renderTarget,
     char clear
 )
 {
-    matrix4x4 cameraMatrix = Matrix4x4_CreateOrthographicOffCenter(
-        camera.x,
-        camera.x + 160,
-        camera.y + 90,
-        camera.y,
-        0,
-        -1
-    );
+    if (frameCommandBuffer == NULL) {
+        TinyDraw_BeginFrame();
+        SpriteBatch_Record_View(pipeline, camera, renderTarget, clear, -1);
+        Frame_End(0);
+        return;
+    }
     
-    SDL_GPUCommandBuffer* cmdbuf = SDL_AcquireGPUCommandBuffer(device);
-    if (cmdbuf == NULL) {
-        SDL_Log("GPUAcquireCommandBuffer failed");
+    const int viewCount = batchViewCount;
+    SpriteBatch_Record_View(pipeline, camera, renderTarget, clear, -1);
+    if (batchViewCount != viewCount) {
+        batchLastRender = viewCount;
+    }
+}
+
+void TinyDraw_Redraw(float3 camera, SDL_GPUTexture* renderTarget)
+{
+    if (frameCommandBuffer == NULL || batchLastRender < 0) {
+        SDL_Log("TinyDraw_Redraw needs a TinyDraw_Render earlier in the same frame");
         return;
     }
-    Uint32 w, h;
-    SDL_GPUTexture* swapchainTexture = renderTarget
-        ? renderTarget
-        : SDL_AcquireGPUSwapchainTexture(cmdbuf, window, &w, &h);
-    if (swapchainTexture != NULL)
-    {
-        SDL_GPUColorAttachmentInfo colorAttachmentInfo = { 0 };
-        colorAttachmentInfo.texture = swapchainTexture;
-        colorAttachmentInfo.clearColor = (SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f };
-        colorAttachmentInfo.loadOp = clear
-            ? SDL_GPU_LOADOP_CLEAR
-            : SDL_GPU_LOADOP_LOAD;
-        colorAttachmentInfo.storeOp = SDL_GPU_STOREOP_STORE;
-        
-        // TODO: depth stencil (goes where `NULL` is here)
-        SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(cmdbuf, &colorAttachmentInfo, 1, NULL);
-        
-        if (spriteBatchCount) {
-            SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
-            SDL_BindGPUVertexBuffers(renderPass, 0, &(SDL_GPUBufferBinding){ .buffer = vertexBuffer, .offset = 0 }, 1);
-            SDL_BindGPUIndexBuffer(renderPass, &(SDL_GPUBufferBinding){ .buffer = indexBuffer, .offset = 0 }, SDL_GPU_INDEXELEMENTSIZE_16BIT);
-            SDL_BindGPUFragmentSamplers(renderPass, 0, &(SDL_GPUTextureSamplerBinding){ .texture = texture, .sampler = sampler }, 1);
-            SDL_PushGPUVertexUniformData(
-                cmdbuf,
-                0,
-                &cameraMatrix,
-                sizeof(matrix4x4)
-            );
-            SDL_DrawGPUIndexedPrimitives(renderPass, spriteBatchCount * 6, 1, 0, 0, 0);
+    
+    const SpriteBatch_View* source = &batchViews[batchLastRender];
+    SpriteBatch_Record_View(source->pipeline, camera, renderTarget, 0, batchLastRender);
+}
+
+int TinyDraw_Read_RenderTarget(
+    SDL_GPUTexture* renderTarget,
+    ReadbackCallback callback,
+    void* userdata
+)
+{
+    if (frameCommandBuffer == NULL) {
+        SDL_Log("TinyDraw_Read_RenderTarget only works inside a frame");
+        return 0;
+    }
+    
+    if (renderTarget == NULL || callback == NULL || Transient_Find(renderTarget) != NULL) {
+        SDL_Log("Can only read back a render target, with a callback");
+        return 0;
+    }
+    
+    for (int i = 0; i < TINYDRAW_READBACK_MAX; i++) {
+        Readback_Slot* slot = &readbackSlots[i];
+        if (slot->state != READBACK_FREE) {
+            continue;
         }
+        
+        slot->state = READBACK_REQUESTED;
+        slot->texture = renderTarget;
+        slot->size = RenderTarget_Size(renderTarget);
+        slot->callback = callback;
+        slot->userdata = userdata;
+        
+        return 1;
+    }
+    
+    return 0;
+}
 
-        SDL_EndGPURenderPass(renderPass);
+void TinyDraw_Set_Mipmaps(char enabled)
+{
+    samplerMipmaps = enabled;
+}
+
+SDL_GPUSampler* TinyDraw_Get_Sampler(int filter, int addressMode)
+{
+    if (filter < 0 || filter > 1 || addressMode < 0 || addressMode > 2) {
+        SDL_Log("Invalid sampler filter or address mode");
+        return NULL;
     }
     
-    SDL_SubmitGPU(cmdbuf);
+    if (samplerCache[filter][addressMode] == NULL) {
+        static const SDL_GPUSamplerAddressMode addressModes[] = {
+            SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+            SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+            SDL_GPU_SAMPLERADDRESSMODE_MIRRORED_REPEAT,
+        };
+        const SDL_GPUSamplerAddressMode address = addressModes[addressMode];
+        samplerCache[filter][addressMode] = SDL_CreateGPUSampler(device, &(SDL_GPUSamplerCreateInfo){
+            .minFilter = filter ? SDL_GPU_FILTER_LINEAR : SDL_GPU_FILTER_NEAREST,
+            .magFilter = filter ? SDL_GPU_FILTER_LINEAR : SDL_GPU_FILTER_NEAREST,
+            .mipmapMode = filter ? SDL_GPU_SAMPLERMIPMAPMODE_LINEAR : SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+            .addressModeU = address,
+            .addressModeV = address,
+            .addressModeW = address,
+            // Every mip level a texture has
+            .maxLod = 1000.0f,
+        });
+        if (samplerCache[filter][addressMode] == NULL) {
+            SDL_Log("Failed to create sampler");
+        }
+    }
     
-    spriteBatchCount = 0;
+    return samplerCache[filter][addressMode];
+}
+
+void TinyDraw_Set_Texture_Sampler(SDL_GPUTexture* texture, int filter, int addressMode)
+{
+    SDL_GPUSampler* textureSampler = TinyDraw_Get_Sampler(filter, addressMode);
+    if (textureSampler == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < samplerOverrideCount; i++) {
+        if (samplerOverrides[i].texture == texture) {
+            samplerOverrides[i].sampler = textureSampler;
+            return;
+        }
+    }
+    
+    if (samplerOverrideCount == SAMPLER_OVERRIDE_MAX) {
+        SDL_Log("Too many textures with their own sampler");
+        return;
+    }
+    
+    samplerOverrides[samplerOverrideCount++] = (Sampler_Override){
+        .texture = texture,
+        .sampler = textureSampler,
+    };
+}
+
+void TinyDraw_Set_Culling(char enabled, float margin)
+{
+    cullEnabled = enabled;
+    cullMargin = margin;
+}
+
+FrameStats TinyDraw_Get_Frame_Stats(void)
+{
+    return frameStatsLast;
 }
 
 void TinyDraw_Clear(SDL_GPUTexture* renderTarget)
 {
-    TinyDraw_Render(NULL, NULL, (float3){}, renderTarget, 1);
+    TinyDraw_Render(NULL, (float3){}, renderTarget, 1);
 }
 
 void TinyDraw_Destroy_Pipeline(SDL_GPUGraphicsPipeline* pipeline)
 {
+    for (int i = 0; i < pipelineInfoCount; i++) {
+        if (pipelineInfos[i].pipeline == pipeline) {
+            if (--pipelineInfos[i].references > 0) {
+                return;
+            }
+            pipelineInfos[i] = pipelineInfos[--pipelineInfoCount];
+            break;
+        }
+    }
+    
     SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
 }
 
 void TinyDraw_Unload_Shader(SDL_GPUShader* shader)
 {
+    if (shader == NULL) {
+        return;
+    }
+    
+    // Pipelines keep working without their shaders, but can't be shared
+    // anymore
+    for (int i = 0; i < pipelineInfoCount; i++) {
+        if (pipelineInfos[i].vertexShader == shader) {
+            pipelineInfos[i].vertexShader = NULL;
+        }
+        if (pipelineInfos[i].fragmentShader == shader) {
+            pipelineInfos[i].fragmentShader = NULL;
+        }
+    }
+    
     SDL_ReleaseGPUShader(device, shader);
 }
 
 void TinyDraw_Unload_Texture(SDL_GPUTexture* texture)
 {
+    for (int i = 0; i < renderTargetCount; i++) {
+        if (renderTargets[i].texture == texture) {
+            renderTargets[i] = renderTargets[--renderTargetCount];
+            break;
+        }
+    }
+    
+    // Not downloaded yet, which would read the released texture
+    for (int i = 0; i < TINYDRAW_READBACK_MAX; i++) {
+        if (readbackSlots[i].state == READBACK_REQUESTED && readbackSlots[i].texture == texture) {
+            readbackSlots[i].state = READBACK_FREE;
+        }
+    }
+    
+    for (int i = 0; i < samplerOverrideCount; i++) {
+        if (samplerOverrides[i].texture == texture) {
+            samplerOverrides[i] = samplerOverrides[--samplerOverrideCount];
+            break;
+        }
+    }
+    
     SDL_ReleaseGPUTexture(device, texture);
 }
 
 void TinyDraw_Quit(void)
 {
+    TextureLoad_Stop();
+    while (frameFenceCount > 0) {
+        SDL_WaitForGPUFences(device, SDL_TRUE, &frameFences[0].fence, 1);
+        Frame_Retire();
+    }
+    Readback_Deliver(0);
+    for (int i = 0; i < TINYDRAW_READBACK_MAX; i++) {
+        if (readbackSlots[i].transferBuffer != NULL) {
+            SDL_ReleaseGPUTransferBuffer(device, readbackSlots[i].transferBuffer);
+        }
+        readbackSlots[i] = (Readback_Slot){ 0 };
+    }
     TinyDraw_Unload_Shader(vertexShader);
     TinyDraw_Unload_Shader(fragmentShader);
-    SDL_ReleaseGPUBuffer(device, vertexBuffer);
+    SpriteBatch_Release_Buffer(&vertexStream);
+    SpriteBatch_Release_Buffer(&instanceStream);
+    SpriteBatch_Release_Buffer(&storageStream);
+    SDL_free(cullKeep);
+    cullKeep = NULL;
+    cullKeepCapacity = 0;
     SDL_ReleaseGPUBuffer(device, indexBuffer);
-    SDL_ReleaseGPUSampler(device, sampler);
-    SDL_UnclaimGPUWindow(device, window);
-    SDL_DestroyWindow(window);
+    if (indexBuffer32 != NULL) {
+        SDL_ReleaseGPUBuffer(device, indexBuffer32);
+    }
+    SpriteBatch_Store_Free(&spriteBatch);
+    SDL_free(spriteBatchKeys);
+    SDL_free(batchDraws);
+    for (int filter = 0; filter < 2; filter++) {
+        for (int addressMode = 0; addressMode < 3; addressMode++) {
+            if (samplerCache[filter][addressMode] != NULL) {
+                SDL_ReleaseGPUSampler(device, samplerCache[filter][addressMode]);
+                samplerCache[filter][addressMode] = NULL;
+            }
+        }
+    }
+    sampler = NULL;
+    samplerOverrideCount = 0;
+    SDL_free(cachePath);
+    cachePath = NULL;
+    for (int i = 0; i < depthTargetCount; i++) {
+        SDL_ReleaseGPUTexture(device, depthTargets[i].texture);
+    }
+    depthTargetCount = 0;
+    for (int i = 0; i < transientPoolCount; i++) {
+        SDL_ReleaseGPUTexture(device, transientPool[i].texture);
+    }
+    SDL_free(transientPool);
+    transientPool = NULL;
+    transientPoolCount = 0;
+    if (window != NULL) {
+        SDL_UnclaimGPUWindow(device, window);
+        SDL_DestroyWindow(window);
+        window = NULL;
+    }
     SDL_DestroyGPUDevice(device);
 }
 
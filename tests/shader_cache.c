@@ -0,0 +1,185 @@
+// Test of the disk cache of shaders translated from SPIR-V.
+//
+// Cached translations that are truncated, corrupt or of another cache
+// version are never loaded, so the shader is translated again. On backends
+// that cache shaders (Metal, D3D11 & D3D12) a real cache file is truncated &
+// corrupted too, & the shader must still load through it & be cached anew.
+// Exits with 1 on any failure. Run with `make test`.
+
+#define TINYDRAW_IMPLEMENTATION
+#include "tinydraw.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC SDL_malloc
+#define STBI_REALLOC SDL_realloc
+#define STBI_FREE SDL_free
+#include "vendor/stb_image.h"
+
+static int failures = 0;
+
+static void Check(char passed, const char* what)
+{
+    SDL_Log("%s  %s", passed ? "ok    " : "FAILED", what);
+    failures += !passed;
+}
+
+static char Exists(const char* path)
+{
+    SDL_IOStream* file = SDL_IOFromFile(path, "rb");
+    if (file != NULL) {
+        SDL_CloseIO(file);
+    }
+    
+    return file != NULL;
+}
+
+static char Write_File(const char* path, const void* data, size_t size)
+{
+    SDL_IOStream* file = SDL_IOFromFile(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    const char written = SDL_WriteIO(file, data, size) == size;
+    return SDL_CloseIO(file) && written;
+}
+
+/**
+ * Whether `path` holds a complete translation, which is equal to `code` if
+ * that isn't `NULL`.
+ */
+static char Is_Cached(const char* path, const void* code, size_t size)
+{
+    size_t cachedSize = 0;
+    void* cached = Shader_Cache_Load(path, &cachedSize);
+    const char equal = cached != NULL
+        && (code == NULL || (cachedSize == size && SDL_memcmp(cached, code, size) == 0));
+    SDL_free(cached);
+    
+    return equal;
+}
+
+/**
+ * Damage the file at `path` & check it isn't loaded, nor left behind.
+ */
+static void Check_Damaged(const char* path, const Uint8* file, size_t size, const char* what)
+{
+    Check(Write_File(path, file, size), "write a damaged cache file");
+    Check(!Is_Cached(path, NULL, 0), what);
+    Check(!Exists(path), "damaged cache file is removed");
+}
+
+static void Test_Cache_File(void)
+{
+    char* folder = SDL_GetPrefPath("TinyDraw", "tests");
+    if (folder == NULL) {
+        Check(0, "no folder to cache into");
+        return;
+    }
+    char path[512];
+    SDL_snprintf(path, sizeof(path), "%sshader_cache_test.shader", folder);
+    SDL_free(folder);
+    
+    const char code[] = "kernel void main0() {}";
+    Shader_Cache_Save(path, code, sizeof(code));
+    Check(Is_Cached(path, code, sizeof(code)), "cached translation loads");
+    
+    size_t size = 0;
+    Uint8* file = SDL_LoadFile(path, &size);
+    if (file == NULL) {
+        Check(0, "cache file is written");
+        return;
+    }
+    
+    Check_Damaged(path, file, size - 1, "truncated translation isn't loaded");
+    Check_Damaged(path, file, sizeof(Shader_Cache_Header) - 1, "truncated header isn't loaded");
+    Check_Damaged(path, file, 0, "empty file isn't loaded");
+    
+    file[size - 2] ^= 0xFF;
+    Check_Damaged(path, file, size, "corrupt translation isn't loaded");
+    file[size - 2] ^= 0xFF;
+    
+    Shader_Cache_Header header;
+    SDL_memcpy(&header, file, sizeof(header));
+    header.version++;
+    SDL_memcpy(file, &header, sizeof(header));
+    Check_Damaged(path, file, size, "translation of another version isn't loaded");
+    
+    SDL_free(file);
+}
+
+/**
+ * Truncate & corrupt the cached translation of a real shader, which must
+ * then be translated & cached again.
+ */
+static void Test_Shader(void)
+{
+    const SDL_GPUShaderFormat format = Shader_Cache_Format();
+    if (format == SDL_GPU_SHADERFORMAT_INVALID) {
+        SDL_Log("skip    this backend doesn't cache shaders");
+        return;
+    }
+    
+    SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/shaders/sprite.vert.spv", basePath);
+    size_t codeSize = 0;
+    void* code = SDL_LoadFile(fullPath, &codeSize);
+    const SDL_GPUShaderCreateInfo info = {
+        .code = code,
+        .codeSize = codeSize,
+        .entryPointName = "main",
+        .format = SDL_GPU_SHADERFORMAT_SPIRV,
+        .stage = SDL_GPU_SHADERSTAGE_VERTEX,
+        .uniformBufferCount = 1,
+    };
+    char path[512];
+    if (code == NULL || !Shader_Cache_Path(&info, format, path, sizeof(path))) {
+        Check(0, "load sprite.vert & find the shader cache");
+        SDL_free(code);
+        return;
+    }
+    SDL_RemovePath(path);
+    
+    SDL_GPUShader* shader = Shader_Load_Cached(&info);
+    Check(shader != NULL, "shader is translated");
+    Check(Is_Cached(path, NULL, 0), "translation is cached");
+    SDL_ReleaseGPUShader(device, shader);
+    
+    size_t size = 0;
+    Uint8* file = SDL_LoadFile(path, &size);
+    if (file != NULL) {
+        Check(Write_File(path, file, size / 2), "truncate the cached translation");
+        shader = Shader_Load_Cached(&info);
+        Check(shader != NULL, "shader loads through a truncated cache file");
+        Check(
+            Is_Cached(path, file + sizeof(Shader_Cache_Header), size - sizeof(Shader_Cache_Header)),
+            "same translation is cached again"
+        );
+        SDL_ReleaseGPUShader(device, shader);
+        
+        file[size - 2] ^= 0xFF;
+        Check(Write_File(path, file, size), "corrupt the cached translation");
+        shader = Shader_Load_Cached(&info);
+        Check(shader != NULL, "shader loads through a corrupt cache file");
+        Check(Is_Cached(path, NULL, 0), "translation is cached again");
+        SDL_ReleaseGPUShader(device, shader);
+        
+        SDL_free(file);
+    }
+    SDL_free(code);
+}
+
+int main(void)
+{
+    Test_Cache_File();
+    
+    if (TinyDraw_Init_Headless()) {
+        Test_Shader();
+        TinyDraw_Quit();
+    } else {
+        Check(0, "init TinyDraw");
+    }
+    
+    SDL_Log("%d failed", failures);
+    
+    return failures > 0;
+}
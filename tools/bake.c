@@ -0,0 +1,160 @@
+// Bakes every PNG in a directory into one texture pack, read by
+// `TinyDraw_Load_Pack`. Each image becomes a texture with its full mip chain,
+// stored as raw RGBA8, & a region named after its file.
+//
+// Usage: bake <sprite directory> <pack file>. Run with `make bake`.
+
+// For the decoder & mip builder TinyDraw loads textures with
+#define TINYDRAW_IMPLEMENTATION
+#include "tinydraw.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC SDL_malloc
+#define STBI_REALLOC SDL_realloc
+#define STBI_FREE SDL_free
+#include "vendor/stb_image.h"
+
+#define BAKE_ALIGNMENT 16
+
+typedef struct Bake_Image
+{
+    const char* name;
+    PackTexture texture;
+    // Every mip level, back to back
+    Uint8* texels;
+} Bake_Image;
+
+static int Compare_Names(const void* a, const void* b)
+{
+    return SDL_strcmp(*(const char* const*) a, *(const char* const*) b);
+}
+
+/**
+ * Load an image & build its mip chain.
+ */
+static int Bake(const char* directory, Bake_Image* image)
+{
+    char path[512];
+    SDL_snprintf(path, sizeof(path), "%s/%s", directory, image->name);
+    
+    int width, height;
+    Uint32 levelCount;
+    image->texels = Texture_Decode(path, &width, &height, &levelCount);
+    if (image->texels == NULL) {
+        return 0;
+    }
+    
+    image->texture = (PackTexture){
+        .width = width,
+        .height = height,
+        .levelCount = levelCount,
+        .format = TINYDRAW_PACK_FORMAT_RGBA8,
+        .size = Texture_Size(SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, width, height, levelCount),
+    };
+    
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        SDL_Log("Usage: %s <sprite directory> <pack file>", argv[0]);
+        return 1;
+    }
+    
+    TinyDraw_Set_Mipmaps(1);
+    
+    int count = 0;
+    char** names = SDL_GlobDirectory(argv[1], "*.png", 0, &count);
+    if (names == NULL) {
+        SDL_Log("Failed to list `%s`: %s", argv[1], SDL_GetError());
+        return 1;
+    }
+    // Sorted, so the same sprites always bake to the same pack
+    SDL_qsort(names, count, sizeof(char*), Compare_Names);
+    
+    Bake_Image* images = SDL_calloc(count + 1, sizeof(Bake_Image));
+    if (images == NULL) {
+        SDL_Log("Failed to allocate images");
+        SDL_free(names);
+        return 1;
+    }
+    
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        images[i].name = names[i];
+        if (SDL_strlen(names[i]) >= TINYDRAW_PACK_NAME_LENGTH) {
+            SDL_Log("Sprite name `%s` is too long", names[i]);
+            result = 1;
+            break;
+        }
+        if (!Bake(argv[1], &images[i])) {
+            result = 1;
+            break;
+        }
+    }
+    
+    // Header, texture index & regions, then the texel data
+    PackHeader header = {
+        .magic = TINYDRAW_PACK_MAGIC,
+        .version = TINYDRAW_PACK_VERSION,
+        .textureCount = count,
+        .regionCount = count,
+    };
+    Uint64 indexEnd = sizeof(PackHeader) + (sizeof(PackTexture) + sizeof(PackRegion)) * count;
+    header.dataOffset = (indexEnd + BAKE_ALIGNMENT - 1) / BAKE_ALIGNMENT * BAKE_ALIGNMENT;
+    for (int i = 0; i < count; i++) {
+        images[i].texture.offset = header.dataOffset + header.dataSize;
+        header.dataSize += (images[i].texture.size + BAKE_ALIGNMENT - 1) / BAKE_ALIGNMENT * BAKE_ALIGNMENT;
+    }
+    
+    SDL_IOStream* file = result == 0 ? SDL_IOFromFile(argv[2], "wb") : NULL;
+    if (result == 0 && file == NULL) {
+        SDL_Log("Failed to create `%s`: %s", argv[2], SDL_GetError());
+        result = 1;
+    }
+    
+    if (file != NULL) {
+        char written = SDL_WriteIO(file, &header, sizeof(header)) == sizeof(header);
+        for (int i = 0; i < count; i++) {
+            written &= SDL_WriteIO(file, &images[i].texture, sizeof(PackTexture)) == sizeof(PackTexture);
+        }
+        for (int i = 0; i < count; i++) {
+            PackRegion region = {
+                .texture = i,
+                .width = images[i].texture.width,
+                .height = images[i].texture.height,
+                .sourcePos = { .x = 0, .y = 0 },
+                .sourceSize = { .x = 1, .y = 1 },
+            };
+            SDL_strlcpy(region.name, images[i].name, sizeof(region.name));
+            written &= SDL_WriteIO(file, &region, sizeof(region)) == sizeof(region);
+        }
+        
+        static const Uint8 zeros[BAKE_ALIGNMENT] = { 0 };
+        Uint64 position = indexEnd;
+        for (int i = 0; i < count; i++) {
+            const Bake_Image* image = &images[i];
+            written &= SDL_WriteIO(file, zeros, image->texture.offset - position) == image->texture.offset - position;
+            written &= SDL_WriteIO(file, image->texels, image->texture.size) == image->texture.size;
+            position = image->texture.offset + image->texture.size;
+        }
+        const Uint64 end = header.dataOffset + header.dataSize;
+        written &= SDL_WriteIO(file, zeros, end - position) == end - position;
+        
+        if (!SDL_CloseIO(file) || !written) {
+            SDL_Log("Failed to write `%s`", argv[2]);
+            result = 1;
+        } else {
+            SDL_Log("Baked %d sprites into `%s`, %d bytes", count, argv[2], (int) end);
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        SDL_free(images[i].texels);
+    }
+    SDL_free(images);
+    SDL_free(names);
+    
+    return result;
+}